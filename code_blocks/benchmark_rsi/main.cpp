@@ -0,0 +1,168 @@
+#include <iostream>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include "xtechnical_indicators.hpp"
+
+using namespace std;
+
+/* Прежняя иерархия: update виртуальный, MMA наследует EMA
+ * только ради другого коэффициента сглаживания
+ */
+template <class T>
+class LegacyEMA {
+protected:
+    std::vector<T> data_;
+    T last_data_ = 0;
+    T a = 0;
+    size_t period_ = 0;
+public:
+    LegacyEMA() {};
+
+    LegacyEMA(const size_t period) : period_(period) {
+        data_.reserve(period_);
+        a = 2.0/(T)(period_ + 1.0);
+    }
+
+    virtual ~LegacyEMA() {};
+
+    virtual int update(const T in, T &out) {
+        if(period_ == 0) {
+            out = in;
+            return xtechnical_common::NO_INIT;
+        }
+        if(data_.size() < (size_t)period_) {
+            data_.push_back(in);
+            if(data_.size() == (size_t)period_) {
+                T sum = std::accumulate(data_.begin(), data_.end(), T(0));
+                last_data_ = sum / (T)period_;
+            }
+        } else {
+            last_data_ = a * in + (1.0 - a) * last_data_;
+            out = last_data_;
+            return xtechnical_common::OK;
+        }
+        out = in;
+        return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+    }
+};
+
+template <class T>
+class LegacyMMA : public LegacyEMA<T> {
+public:
+    LegacyMMA(const size_t period) {
+        LegacyEMA<T>::period_ = period;
+        LegacyEMA<T>::data_.reserve(period);
+        LegacyEMA<T>::a = 1.0/(T)period;
+    }
+};
+
+/* RSI, в котором сглаживание выбирается во время работы через
+ * указатель на базовый класс - так прежняя иерархия позволяла
+ * подставлять EMA или MMA
+ */
+template <class T>
+class LegacyRSI {
+private:
+    std::unique_ptr<LegacyEMA<T>> iU;
+    std::unique_ptr<LegacyEMA<T>> iD;
+    bool is_update_ = false;
+    T prev_ = 0;
+public:
+    LegacyRSI(const size_t period, const bool is_wilder) :
+        iU(is_wilder ? new LegacyMMA<T>(period) : new LegacyEMA<T>(period)),
+        iD(is_wilder ? new LegacyMMA<T>(period) : new LegacyEMA<T>(period)) {}
+
+    int update(const T &in, T &out) {
+        if(!is_update_) {
+            prev_ = in;
+            is_update_ = true;
+            out = 50.0;
+            return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+        }
+        T u = 0;
+        T d = 0;
+        if(prev_ < in) {
+            u = in - prev_;
+        } else
+        if(prev_ > in) {
+            d = prev_ - in;
+        }
+        T mu = 0;
+        T md = 0;
+        int erru = iU->update(u, mu);
+        int errd = iD->update(d, md);
+        prev_ = in;
+        if(erru != xtechnical_common::OK || errd != xtechnical_common::OK) {
+            out = 50.0;
+            return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+        }
+        if(md == 0) {
+            out = 100.0;
+            return xtechnical_common::OK;
+        }
+        T rs = mu / md;
+        out = 100.0 - (100.0 / (1.0 + rs));
+        return xtechnical_common::OK;
+    }
+};
+
+template <class RSI_TYPE>
+double run_batch(RSI_TYPE &rsi, const std::vector<double> &prices, std::vector<double> &out) {
+    std::vector<int> status(prices.size());
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    rsi.update_batch(prices.data(), out.data(), status.data(), prices.size());
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (double)prices.size();
+}
+
+template <class RSI_TYPE>
+double run(RSI_TYPE &rsi, const std::vector<double> &prices, std::vector<double> &out) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < prices.size(); ++i) {
+        rsi.update(prices[i], out[i]);
+    }
+    std::chrono::steady_clock::time_point stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(stop - start).count() / (double)prices.size();
+}
+
+int main() {
+    const size_t num_samples = 10000000;
+    const size_t period = 14;
+    std::vector<double> prices(num_samples);
+    double price = 100.0;
+    srand(1);
+    for(size_t i = 0; i < num_samples; ++i) {
+        price += (double)(rand() % 2001 - 1000) * 0.001;
+        prices[i] = price;
+    }
+    std::vector<double> out_legacy(num_samples), out_policy(num_samples), out_batch(num_samples);
+
+    for(int is_wilder = 0; is_wilder <= 1; ++is_wilder) {
+        LegacyRSI<double> legacy_rsi(period, is_wilder);
+        double legacy_time = run(legacy_rsi, prices, out_legacy);
+        double policy_time = 0, batch_time = 0;
+        if(is_wilder) {
+            xtechnical_indicators::RSI<double, xtechnical_indicators::MMA<double>> rsi(period), rsi_batch(period);
+            policy_time = run(rsi, prices, out_policy);
+            batch_time = run_batch(rsi_batch, prices, out_batch);
+        } else {
+            xtechnical_indicators::RSI<double, xtechnical_indicators::EMA<double>> rsi(period), rsi_batch(period);
+            policy_time = run(rsi, prices, out_policy);
+            batch_time = run_batch(rsi_batch, prices, out_batch);
+        }
+        double max_diff = 0;
+        for(size_t i = 0; i < num_samples; ++i) {
+            max_diff = std::max(max_diff, std::abs(out_legacy[i] - out_policy[i]));
+            max_diff = std::max(max_diff, std::abs(out_legacy[i] - out_batch[i]));
+        }
+        std::cout << (is_wilder ? "RSI MMA" : "RSI EMA")
+            << " virtual: " << legacy_time << " ns"
+            << " policy: " << policy_time << " ns"
+            << " policy batch: " << batch_time << " ns"
+            << " max diff: " << max_diff << std::endl;
+    }
+    return 0;
+}
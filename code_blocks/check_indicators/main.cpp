@@ -1,5 +1,7 @@
 #include <iostream>
 #include "xtechnical_indicators.hpp"
+#include "xtechnical_indicator_graph.hpp"
+#include "xtechnical_batch_indicators.hpp"
 
 using namespace std;
 
@@ -80,5 +82,47 @@ int main() {
     std::cout << iVCMA.update(2,1) << std::endl;
     std::cout << iVCMA.update(3,0.5) << std::endl;
     std::cout << iVCMA.update(1,0.5) << std::endl;
+    xtechnical_indicators::IndicatorGraph<double> iGraph;
+    size_t close_id = 0, sma_id = 0, rsi_id = 0, bb_upper_id = 0, bb_lower_id = 0;
+    iGraph.add_input("close", close_id);
+    iGraph.add("SMA(close,20)", sma_id);
+    iGraph.add("RSI(close,14)", rsi_id);
+    iGraph.add("BB_UPPER(close,20,2)", bb_upper_id);
+    iGraph.add("BB_LOWER(close,20,2)", bb_lower_id);
+    std::cout << "graph nodes: " << iGraph.get_num_nodes()
+        << " windows: " << iGraph.get_num_windows() << std::endl;
+    for(int i = 1; i <= 30; ++i) {
+        std::vector<double> inputs(1, (double)(i % 7) + 0.1 * i);
+        iGraph.update(inputs);
+        double sma_out = 0, rsi_out = 0, tl = 0, bl = 0;
+        if(iGraph.get(bb_upper_id, tl) != xtechnical_common::OK) continue;
+        iGraph.get(sma_id, sma_out);
+        iGraph.get(rsi_id, rsi_out);
+        iGraph.get(bb_lower_id, bl);
+        std::cout << "graph SMA: " << sma_out << " RSI: " << rsi_out
+            << " BB: " << tl << " " << bl << std::endl;
+    }
+    /* ошибочное выражение не сбрасывает прогретые индикаторы */
+    size_t bad_id = 0;
+    std::cout << "graph add error: " << iGraph.add("ADD(SMA(close,50),nosuch)", bad_id)
+        << " nodes: " << iGraph.get_num_nodes() << std::endl;
+    double sma_after_error = 0;
+    std::cout << "graph SMA after error: " << iGraph.get(sma_id, sma_after_error)
+        << " " << sma_after_error << std::endl;
+    const size_t num_symbols = 4;
+    xtechnical_indicators::SMABatch<double> iSMABatch(num_symbols, 5);
+    xtechnical_indicators::RSIBatch<double> iRSIBatch(num_symbols, 5);
+    std::vector<double> prices(num_symbols), sma_batch(num_symbols), rsi_batch(num_symbols);
+    std::vector<uint8_t> sma_ready(num_symbols), rsi_ready(num_symbols);
+    for(int i = 1; i <= 10; ++i) {
+        for(size_t s = 0; s < num_symbols; ++s) {
+            prices[s] = (double)((i * (s + 1)) % 5) + 10.0 * s;
+        }
+        iSMABatch.update(prices, sma_batch, sma_ready);
+        if(iRSIBatch.update(prices, rsi_batch, rsi_ready) != xtechnical_common::OK) continue;
+        for(size_t s = 0; s < num_symbols; ++s) {
+            std::cout << "batch " << s << " SMA: " << sma_batch[s] << " RSI: " << rsi_batch[s] << std::endl;
+        }
+    }
     return 0;
 }
@@ -0,0 +1,91 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "xtechnical_indicators.hpp"
+
+using namespace std;
+
+/* максимальная разница двух массивов */
+double get_max_diff(const std::vector<double> &a, const std::vector<double> &b) {
+    double diff = 0;
+    for(size_t i = 0; i < a.size(); ++i) {
+        diff = std::max(diff, std::abs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+int main() {
+    const size_t size = 50;
+    const size_t period = 10;
+    const size_t num_shifts = 200;
+
+    /* массив сдвигается на один элемент: старый удаляется из начала, новый добавляется в конец */
+    std::vector<double> in(size);
+    size_t tick = 0;
+    auto get_value = [](const size_t t) {
+        return 100.0 + 10.0 * std::sin((double)t * 0.1) + (double)(t % 7);
+    };
+    for(; tick < size; ++tick) in[tick] = get_value(tick);
+
+    xtechnical_indicators::RingRSI<double> ring_rsi(period);
+    xtechnical_indicators::RingBollinger<double> ring_bb(period, 2.0);
+    xtechnical_normalization::AutomaticGainControl<double, xtechnical_indicators::SMA<double>> agc_sma(period, true, period);
+    xtechnical_normalization::AutomaticGainControl<double, xtechnical_indicators::LowPassFilter<double>> agc_lpf(period);
+
+    std::vector<double> out(size), out_ring(size);
+    std::vector<double> tl(size), ml(size), bl(size);
+    std::vector<double> tl_ring(size), ml_ring(size), bl_ring(size);
+
+    double max_diff_rsi = 0, max_diff_bb = 0, max_diff_agc_sma = 0, max_diff_agc_lpf = 0;
+    for(size_t n = 0; n <= num_shifts; ++n) {
+        /* разрыв данных: массив пересчитывается полностью */
+        const bool is_shift = (n % 75) != 74;
+        if(n > 0) {
+            if(is_shift) {
+                std::rotate(in.begin(), in.begin() + 1, in.end());
+                in[size - 1] = get_value(tick++);
+            } else {
+                for(size_t i = 0; i < size; ++i) in[i] = get_value(tick++);
+            }
+        }
+
+        xtechnical_indicators::calc_ring_rsi(in, out, period);
+        ring_rsi.update(in, out_ring, is_shift);
+        const double diff_rsi = get_max_diff(out, out_ring);
+        const double last_rsi = out_ring[size - 1];
+        max_diff_rsi = std::max(max_diff_rsi, diff_rsi);
+
+        xtechnical_indicators::calc_ring_bollinger(in, tl, ml, bl, period, 2.0);
+        ring_bb.update(in, tl_ring, ml_ring, bl_ring, is_shift);
+        const double diff_bb = std::max(get_max_diff(tl, tl_ring),
+            std::max(get_max_diff(ml, ml_ring), get_max_diff(bl, bl_ring)));
+        max_diff_bb = std::max(max_diff_bb, diff_bb);
+
+        xtechnical_normalization::calc_automatic_gain_control<xtechnical_indicators::SMA<double>>(in, out, period);
+        agc_sma.update(in, out_ring, is_shift);
+        const double diff_agc_sma = get_max_diff(out, out_ring);
+        max_diff_agc_sma = std::max(max_diff_agc_sma, diff_agc_sma);
+
+        xtechnical_normalization::calc_automatic_gain_control<xtechnical_indicators::LowPassFilter<double>>(in, out, period);
+        agc_lpf.update(in, out_ring, is_shift);
+        const double diff_agc_lpf = get_max_diff(out, out_ring);
+        max_diff_agc_lpf = std::max(max_diff_agc_lpf, diff_agc_lpf);
+
+        if(n % 25 == 0 || !is_shift) {
+            std::cout << "shift " << n << (is_shift ? "" : " (gap)")
+                << " rsi " << last_rsi
+                << " diff " << diff_rsi
+                << " bb " << ml_ring[size - 1]
+                << " diff " << diff_bb
+                << " agc sma diff " << diff_agc_sma
+                << " agc lpf diff " << diff_agc_lpf
+                << std::endl;
+        }
+    }
+    std::cout << "max diff RingRSI: " << max_diff_rsi << std::endl;
+    std::cout << "max diff RingBollinger: " << max_diff_bb << std::endl;
+    std::cout << "max diff AutomaticGainControl (SMA): " << max_diff_agc_sma << std::endl;
+    std::cout << "max diff AutomaticGainControl (LowPassFilter): " << max_diff_agc_lpf << std::endl;
+    return 0;
+}
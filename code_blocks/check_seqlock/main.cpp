@@ -0,0 +1,62 @@
+#include <iostream>
+#include <cmath>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include "xtechnical_indicators.hpp"
+#include "xtechnical_seqlock.hpp"
+
+using namespace std;
+
+int main() {
+    const size_t num_ticks = 200000;
+    const size_t period = 20;
+
+    typedef xtechnical_indicators::BollingerBands<double> Bands;
+    xtechnical_indicators::PublishedIndicator<Bands, double, 3> published(period, 2.0);
+    Bands reference(period, 2.0);
+
+    std::cout << "sizeof(SeqlockSlot<double, 3>): " << sizeof(xtechnical_indicators::SeqlockSlot<double, 3>) << std::endl;
+
+    /* читатель проверяет, что каждый прочитанный набор согласован:
+     * средняя линия лежит между границами, а номер публикации не убывает
+     */
+    std::atomic<bool> is_stop(false);
+    size_t num_reads = 0;
+    size_t num_errors = 0;
+    std::thread reader([&]() {
+        uint64_t last_version = 0;
+        while(!is_stop.load(std::memory_order_acquire)) {
+            double out[3];
+            uint64_t version = 0;
+            const int err = published.get(out, &version);
+            ++num_reads;
+            if(version < last_version) ++num_errors;
+            last_version = version;
+            if(err == xtechnical_common::OK && !(out[2] <= out[1] && out[1] <= out[0])) ++num_errors;
+        }
+    });
+
+    double tl = 0, ml = 0, bl = 0;
+    for(size_t i = 0; i < num_ticks; ++i) {
+        const double value = 100.0 + 10.0 * std::sin((double)i * 0.01) + (double)(i % 7);
+        published.update(value);
+        reference.update(value, tl, ml, bl);
+    }
+    is_stop.store(true, std::memory_order_release);
+    reader.join();
+
+    double out[3];
+    uint64_t version = 0;
+    published.get(out, &version);
+    std::cout << "published " << out[0] << " " << out[1] << " " << out[2] << " version " << version << std::endl;
+    std::cout << "single    " << tl << " " << ml << " " << bl << std::endl;
+    std::cout << "reads: " << num_reads << " errors: " << num_errors << std::endl;
+
+    /* ячейки в массиве не делят линии кэша */
+    xtechnical_indicators::SeqlockSlot<double> *slots = new xtechnical_indicators::SeqlockSlot<double>[2];
+    const size_t distance = (size_t)((const char*)&slots[1] - (const char*)&slots[0]);
+    std::cout << "slot distance: " << distance << " >= " << 2 * xtechnical_common::CACHE_LINE_SIZE << std::endl;
+    delete[] slots;
+    return 0;
+}
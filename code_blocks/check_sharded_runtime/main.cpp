@@ -0,0 +1,61 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <ctime>
+#include "xtechnical_indicators.hpp"
+#include "xtechnical_sharded_runtime.hpp"
+
+using namespace std;
+
+int main() {
+    const size_t num_symbols = 10;
+    const size_t num_ticks = 2000;
+    const size_t period = 14;
+
+    xtechnical_indicators::RSI<double, xtechnical_indicators::SMA<double>> prototype(period);
+    xtechnical_indicators::ShardedRuntime<double, xtechnical_indicators::RSI<double, xtechnical_indicators::SMA<double>>>
+        runtime(num_symbols, prototype, 3, 64);
+    std::vector<xtechnical_indicators::RSI<double, xtechnical_indicators::SMA<double>>> reference(num_symbols, prototype);
+    std::vector<double> reference_out(num_symbols, 0);
+
+    std::cout << "threads: " << runtime.get_num_threads() << std::endl;
+
+    /* тики подаются пачками с паузами, чтобы потоки успевали уснуть
+     * и их будил следующий тик
+     */
+    size_t num_errors = 0;
+    for(size_t i = 0; i < num_ticks; ++i) {
+        for(size_t s = 0; s < num_symbols; ++s) {
+            const double value = 100.0 + 10.0 * std::sin((double)(i * (s + 1)) * 0.01) + (double)((i + s) % 7);
+            runtime.update(s, value);
+            reference[s].update(value, reference_out[s]);
+        }
+        if(i % 500 == 499) {
+            runtime.wait();
+            for(size_t s = 0; s < num_symbols; ++s) {
+                double out = 0;
+                runtime.get(s, out);
+                if(out != reference_out[s]) ++num_errors;
+                std::cout << "tick " << i << " symbol " << s
+                    << " sharded " << out << " single " << reference_out[s] << std::endl;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        }
+    }
+    std::cout << "errors: " << num_errors << std::endl;
+
+    /* простаивающие потоки должны спать, а не занимать ядра */
+    const std::clock_t cpu_start = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    const double cpu_time = (double)(std::clock() - cpu_start) / CLOCKS_PER_SEC;
+    std::cout << "idle cpu time (s): " << cpu_time << std::endl;
+
+    /* количество потоков по умолчанию */
+    xtechnical_indicators::ShardedRuntime<double, xtechnical_indicators::SMA<double>>
+        runtime_default(num_symbols, xtechnical_indicators::SMA<double>(period));
+    std::cout << "default threads: " << runtime_default.get_num_threads()
+        << " hardware concurrency: " << std::thread::hardware_concurrency() << std::endl;
+    return 0;
+}
@@ -0,0 +1,120 @@
+#include <iostream>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include "xtechnical_indicators.hpp"
+
+using namespace std;
+
+const size_t num_samples = 2000;
+
+/* размеры пачек, чтобы граница прогрева попадала внутрь пачки и между пачками */
+const size_t chunk_sizes[] = {1, 3, 7, 64, 300, 1000};
+const size_t num_chunk_sizes = sizeof(chunk_sizes) / sizeof(chunk_sizes[0]);
+
+double get_value(const size_t i) {
+    return 100.0 + 10.0 * std::sin((double)i * 0.05) + (double)(i % 7) * 0.3;
+}
+
+double get_volume(const size_t i) {
+    return 1.0 + (double)(i % 5);
+}
+
+void print_result(const char *name, const double max_diff, const size_t num_status_errors) {
+    std::cout << name << " max diff: " << max_diff << " status errors: " << num_status_errors << std::endl;
+}
+
+/* индикатор с одним входом и одним выходом */
+template <class INDICATOR_TYPE>
+void check(const char *name, const INDICATOR_TYPE &prototype) {
+    INDICATOR_TYPE indicator(prototype), batch(prototype);
+    std::vector<double> in(num_samples), out(num_samples), out_batch(num_samples);
+    std::vector<int> status(num_samples), status_batch(num_samples);
+    for(size_t i = 0; i < num_samples; ++i) {
+        in[i] = get_value(i);
+        status[i] = indicator.update(in[i], out[i]);
+    }
+    size_t pos = 0, k = 0;
+    while(pos < num_samples) {
+        const size_t n = std::min(chunk_sizes[k++ % num_chunk_sizes], num_samples - pos);
+        batch.update_batch(&in[pos], &out_batch[pos], &status_batch[pos], n);
+        pos += n;
+    }
+    double max_diff = 0;
+    size_t num_status_errors = 0;
+    for(size_t i = 0; i < num_samples; ++i) {
+        if(status[i] != status_batch[i]) ++num_status_errors;
+        if(status[i] == xtechnical_common::OK) max_diff = std::max(max_diff, std::abs(out[i] - out_batch[i]));
+    }
+    print_result(name, max_diff, num_status_errors);
+}
+
+/* индикатор с двумя входами (цена и объем) */
+template <class INDICATOR_TYPE>
+void check_volume(const char *name, const INDICATOR_TYPE &prototype) {
+    INDICATOR_TYPE indicator(prototype), batch(prototype);
+    std::vector<double> in(num_samples), volume(num_samples), out(num_samples), out_batch(num_samples);
+    std::vector<int> status(num_samples), status_batch(num_samples);
+    for(size_t i = 0; i < num_samples; ++i) {
+        in[i] = get_value(i);
+        volume[i] = get_volume(i);
+        status[i] = indicator.update(in[i], volume[i], out[i]);
+    }
+    size_t pos = 0, k = 0;
+    while(pos < num_samples) {
+        const size_t n = std::min(chunk_sizes[k++ % num_chunk_sizes], num_samples - pos);
+        batch.update_batch(&in[pos], &volume[pos], &out_batch[pos], &status_batch[pos], n);
+        pos += n;
+    }
+    double max_diff = 0;
+    size_t num_status_errors = 0;
+    for(size_t i = 0; i < num_samples; ++i) {
+        if(status[i] != status_batch[i]) ++num_status_errors;
+        if(status[i] == xtechnical_common::OK) max_diff = std::max(max_diff, std::abs(out[i] - out_batch[i]));
+    }
+    print_result(name, max_diff, num_status_errors);
+}
+
+int main() {
+    using namespace xtechnical_indicators;
+    check("SMA", SMA<double>(20));
+    check("EMA", EMA<double>(20));
+    check("MMA", MMA<double>(20));
+    check("WMA", WMA<double>(20));
+    check("SUM", SUM<double>(20));
+    check("RSI<SMA>", RSI<double, SMA<double>>(14));
+    check("RSI<MMA>", RSI<double, MMA<double>>(14));
+    check("LowPassFilter", LowPassFilter<double>(10));
+    check("AMA", AMA<double>(10));
+    check("RoC", RoC<double>(10));
+    check_volume("VWMA", VWMA<double>(20));
+    check_volume("MFI<SMA>", MFI<double, SMA<double>>(14));
+
+    /* у BollingerBands три выхода */
+    BollingerBands<double> bb(20, 2.0), bb_batch(20, 2.0);
+    std::vector<double> in(num_samples);
+    std::vector<double> tl(num_samples), ml(num_samples), bl(num_samples);
+    std::vector<double> tl_batch(num_samples), ml_batch(num_samples), bl_batch(num_samples);
+    std::vector<int> status(num_samples), status_batch(num_samples);
+    for(size_t i = 0; i < num_samples; ++i) {
+        in[i] = get_value(i);
+        status[i] = bb.update(in[i], tl[i], ml[i], bl[i]);
+    }
+    size_t pos = 0, k = 0;
+    while(pos < num_samples) {
+        const size_t n = std::min(chunk_sizes[k++ % num_chunk_sizes], num_samples - pos);
+        bb_batch.update_batch(&in[pos], &tl_batch[pos], &ml_batch[pos], &bl_batch[pos], &status_batch[pos], n);
+        pos += n;
+    }
+    double max_diff = 0;
+    size_t num_status_errors = 0;
+    for(size_t i = 0; i < num_samples; ++i) {
+        if(status[i] != status_batch[i]) ++num_status_errors;
+        if(status[i] != xtechnical_common::OK) continue;
+        max_diff = std::max(max_diff, std::abs(tl[i] - tl_batch[i]));
+        max_diff = std::max(max_diff, std::abs(ml[i] - ml_batch[i]));
+        max_diff = std::max(max_diff, std::abs(bl[i] - bl_batch[i]));
+    }
+    print_result("BollingerBands", max_diff, num_status_errors);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <iostream>
+#include "xtechnical_correlation.hpp"
+#include <vector>
+
+int main() {
+    std::cout << "Hello world!" << std::endl;
+    std::vector<double> test_x = {1,2,3,4,5,6,7,8,9,10,9,8,7,6};
+    std::vector<double> test_y = {2,4,5,4,5,7,8,9,12,11,10,8,8,5};
+
+    const size_t period = 6;
+    xtechnical_correlation::RollingPearson<double> iRollingPearson(period);
+    for(size_t i = 0; i < test_x.size(); ++i) {
+        double rxy_test = 0;
+        iRollingPearson.test(test_x[i], test_y[i], rxy_test);
+        double rxy = 0;
+        int err = iRollingPearson.update(test_x[i], test_y[i], rxy);
+        if(err != xtechnical_common::OK) continue;
+
+        std::vector<double> x(test_x.begin() + i + 1 - period, test_x.begin() + i + 1);
+        std::vector<double> y(test_y.begin() + i + 1 - period, test_y.begin() + i + 1);
+        double rxy_check = 0;
+        xtechnical_correlation::calculate_pearson_correlation_coefficient(x, y, rxy_check);
+        std::cout << "rolling pearson: " << rxy << " test: " << rxy_test << " check: " << rxy_check << std::endl;
+    }
+
+    xtechnical_correlation::CorrelationMatrix<double> iCorrelationMatrix(period, 2);
+    for(size_t i = 0; i < test_x.size(); ++i) {
+        std::vector<double> row = {test_x[i], test_y[i]};
+        if(iCorrelationMatrix.update(row) != xtechnical_common::OK) continue;
+        double rxy = 0;
+        iCorrelationMatrix.get_correlation(rxy, 0, 1);
+        std::cout << "correlation matrix: " << rxy << std::endl;
+    }
+
+    xtechnical_correlation::RollingSpearman<double> iRollingSpearman(period);
+    xtechnical_correlation::RollingKendall<double> iRollingKendall(period);
+    for(size_t i = 0; i < test_x.size(); ++i) {
+        double p = 0, tau = 0;
+        int err_p = iRollingSpearman.update(test_x[i], test_y[i], p);
+        int err_tau = iRollingKendall.update(test_x[i], test_y[i], tau);
+        if(err_p != xtechnical_common::OK || err_tau != xtechnical_common::OK) continue;
+        std::cout << "rolling spearman: " << p << " rolling kendall: " << tau << std::endl;
+    }
+
+    std::vector<std::vector<double>> test_data = {test_x, test_y, test_x};
+    std::vector<double> packed;
+    xtechnical_correlation::calculate_correlation_matrix(
+        test_data,
+        packed,
+        xtechnical_correlation::SPEARMAN_RANK_CORRELATION);
+    std::cout << "calculate_correlation_matrix (SPEARMAN_RANK_CORRELATION):" << std::endl;
+    for(size_t i = 0; i < packed.size(); ++i) {
+        std::cout << packed[i] << std::endl;
+    }
+
+    std::vector<int> is_significant;
+    xtechnical_correlation::check_correlation_matrix_t_criterion(
+        packed,
+        is_significant,
+        xtechnical_correlation::BI_CRITICAl_AREA_0P05,
+        test_x.size());
+    std::cout << "check_correlation_matrix_t_criterion:" << std::endl;
+    for(size_t i = 0; i < is_significant.size(); ++i) {
+        std::cout << is_significant[i] << std::endl;
+    }
+    std::cout << "critical t (0.05, df 7.5): "
+        << xtechnical_correlation::calculate_critical_t_point(0.05, 7.5) << std::endl;
+
+    std::vector<double> ccf;
+    xtechnical_correlation::calculate_cross_correlation(test_x, test_y, 3, ccf);
+    int lag = 0;
+    double lag_coeff = 0;
+    xtechnical_correlation::find_cross_correlation_lag(ccf, lag, lag_coeff);
+    std::cout << "calculate_cross_correlation:" << std::endl;
+    for(size_t i = 0; i < ccf.size(); ++i) {
+        std::cout << ((int)i - 3) << " " << ccf[i] << std::endl;
+    }
+    std::cout << "lag: " << lag << " coeff: " << lag_coeff << std::endl;
+    return 0;
+}
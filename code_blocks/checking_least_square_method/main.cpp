@@ -48,5 +48,43 @@ int main() {
     xtechnical_regression_analysis::calc_least_squares_method(coeff, test_data3, 6, xtechnical_regression_analysis::LSM_PARABOLA);
     out_data = xtechnical_regression_analysis::calc_line(coeff, in_data, xtechnical_regression_analysis::LSM_PARABOLA);
     std::cout << "out_data " << out_data << std::endl;
+
+    xtechnical_regression_analysis::RollingLeastSquares<double> rolling_lsm(4, xtechnical_regression_analysis::LSM_PARABOLA);
+    const double test_data4[8] = {1, 2, 4, 7, 11, 16, 22, 29};
+    for(size_t i = 0; i < 8; ++i) {
+        if(rolling_lsm.update(test_data4[i]) != xtechnical_common::OK) continue;
+        std::cout << "rolling lsm: slope " << rolling_lsm.get_slope()
+            << " curvature " << rolling_lsm.get_curvature()
+            << " r2 " << rolling_lsm.get_r_squared()
+            << " forecast " << rolling_lsm.get_forecast(1) << std::endl;
+    }
+
+    std::vector<double> poly_x, poly_y;
+    for(size_t i = 0; i < 10; ++i) {
+        const double x = (double)i;
+        poly_x.push_back(x);
+        poly_y.push_back(1.0 - 2.0 * x + 0.5 * x * x + 0.1 * x * x * x);
+    }
+    std::vector<double> poly_coeff;
+    xtechnical_regression_analysis::calc_polynomial_regression(poly_x, poly_y, 3, poly_coeff);
+    std::cout << "polynomial regression:";
+    for(size_t i = 0; i < poly_coeff.size(); ++i) {
+        std::cout << " " << poly_coeff[i];
+    }
+    std::cout << std::endl;
+
+    /* 3 выборки по 6 баров в формате SoA */
+    std::vector<double> batch_y(6 * 3);
+    for(size_t i = 0; i < 6; ++i) {
+        batch_y[i * 3 + 0] = test_data[i][1];
+        batch_y[i * 3 + 1] = 2.0 * test_data[i][1];
+        batch_y[i * 3 + 2] = -test_data[i][1];
+    }
+    xtechnical_regression_analysis::BatchLeastSquares<double> batch_lsm(6, xtechnical_regression_analysis::LSM_LINE);
+    std::vector<double> batch_coeff;
+    batch_lsm.calc(batch_y, 3, batch_coeff);
+    for(size_t s = 0; s < 3; ++s) {
+        std::cout << "batch lsm: A0 " << batch_coeff[s] << " A1 " << batch_coeff[3 + s] << std::endl;
+    }
     return 0;
 }
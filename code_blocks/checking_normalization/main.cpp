@@ -50,5 +50,23 @@ int main() {
     for(size_t i = 0; i < out_data.size(); ++i) {
         std::cout << out_data[i] << std::endl;
     }
+
+    xtechnical_normalization::RollingMinMax<double> rolling_min_max(3, xtechnical_common::MINMAX_SIGNED);
+    xtechnical_normalization::RollingZScore<double> rolling_zscore(3);
+    std::cout << "rolling min max / z-score:" << std::endl;
+    for(size_t i = 0; i < test_data.size(); ++i) {
+        double min_max_value = 0, zscore_value = 0;
+        if(rolling_min_max.update(test_data[i], min_max_value) != xtechnical_common::OK) continue;
+        rolling_zscore.update(test_data[i], zscore_value);
+        std::cout << min_max_value << " " << zscore_value << std::endl;
+    }
+    xtechnical_normalization::TransformPipeline<double> pipeline;
+    pipeline.add_log().add_difference().add_zscore().add_clip(-1, 1);
+    size_t pipeline_size = 0;
+    pipeline.calc(test_data, out_data, pipeline_size);
+    std::cout << "pipeline log -> difference -> zscore -> clip:" << std::endl;
+    for(size_t i = 0; i < pipeline_size; ++i) {
+        std::cout << out_data[i] << std::endl;
+    }
     return 0;
 }
@@ -1,7 +1,11 @@
 #include <iostream>
 #include "xtechnical_statistics.hpp"
+#include "xtechnical_quantile_sketch.hpp"
 #include <array>
 #include <vector>
+#include <limits>
+#include <cstring>
+#include <cstdint>
 
 int main() {
     std::cout << "Hello world!" << std::endl;
@@ -28,6 +32,31 @@ int main() {
     std::vector<double> test_data3 = {1.1,1.1,1.1,1.1,1.1,1.1};
     test_out[0] = xtechnical_statistics::calc_median<double>(test_data3);
     std::cout << "median: " << test_out[0] << std::endl;
+    std::cout << "quantile 0.25: " << xtechnical_statistics::calc_quantile<double>(test_data, 0.25) << std::endl;
+
+    xtechnical_statistics::RollingQuantile<double> rolling_median(3);
+    for(size_t i = 0; i < test_data.size(); ++i) {
+        double median = 0;
+        if(rolling_median.update(test_data[i], median) != xtechnical_common::OK) continue;
+        std::cout << "rolling median: " << median << std::endl;
+    }
+
+    xtechnical_statistics::TDigest<double> digest(100);
+    for(size_t i = 0; i < 10000; ++i) {
+        digest.add((double)(i % 1000));
+    }
+    std::string digest_data;
+    digest.serialize(digest_data);
+    xtechnical_statistics::TDigest<double> digest_copy;
+    digest_copy.deserialize(digest_data);
+    std::cout << "t-digest p50: " << digest_copy.get_quantile(0.5)
+        << " p99: " << digest_copy.get_quantile(0.99) << std::endl;
+    digest_copy.merge(digest_copy);
+    std::cout << "t-digest self-merge count: " << digest_copy.get_count()
+        << " p50: " << digest_copy.get_quantile(0.5) << std::endl;
+    double bad_compression = std::numeric_limits<double>::infinity();
+    std::memcpy(&digest_data[sizeof(uint32_t)], &bad_compression, sizeof(double));
+    std::cout << "t-digest deserialize (inf compression): " << digest_copy.deserialize(digest_data) << std::endl;
 
 
     std::vector<double> test_data4 = {1,1,2,2,3,3,4,5,6,7};
@@ -39,6 +68,25 @@ int main() {
     double standard_error = xtechnical_statistics::calc_standard_error<double>(test_data5);
     std::cout << "standard_error: " << standard_error << std::endl;
 
+    xtechnical_statistics::DescriptiveStats<double> stats =
+        xtechnical_statistics::calc_descriptive_stats<double>(test_data4);
+    std::cout << "descriptive stats: mean " << stats.mean
+        << " std_dev " << stats.std_dev
+        << " excess " << stats.excess
+        << " min " << stats.min
+        << " max " << stats.max << std::endl;
+
+    xtechnical_statistics::Moments<double> moments_left, moments_right;
+    for(size_t i = 0; i < test_data4.size(); ++i) {
+        if(i < test_data4.size() / 2) moments_left.push(test_data4[i]);
+        else moments_right.push(test_data4[i]);
+    }
+    moments_left.merge(moments_right);
+    std::cout << "moments: std_dev " << moments_left.get_std_dev()
+        << " excess " << moments_left.get_excess() << std::endl;
+    moments_left.pop(test_data4[0]);
+    std::cout << "moments after pop: mean " << moments_left.get_mean() << std::endl;
+
     double integral_laplace = xtechnical_statistics::calc_integral_laplace<double>(0.01, 0.00001);
     std::cout << "integral_laplace: " << integral_laplace << std::endl;
     double integral_laplace2 = xtechnical_statistics::calc_integral_laplace<double>(1.51, 0.01);
@@ -55,5 +103,14 @@ int main() {
 
     p_bet = xtechnical_statistics::calc_probability_winrate<double>(0.57, 1, 1);
     std::cout << "p_bet (1): " << p_bet << std::endl;
+
+    std::vector<int> win_bets = {31, 5700, 1, 0, 20};
+    std::vector<int> number_bets = {44, 10000, 1, 10, 20};
+    std::vector<double> p_bets(win_bets.size());
+    xtechnical_statistics::calc_probability_winrate(0.56, win_bets.data(), number_bets.data(), p_bets.data(), p_bets.size());
+    for(size_t i = 0; i < p_bets.size(); ++i) {
+        std::cout << "p_bet batch: " << p_bets[i] << " scalar: "
+            << xtechnical_statistics::calc_probability_winrate<double>(0.56, win_bets[i], number_bets[i]) << std::endl;
+    }
     return 0;
 }
@@ -0,0 +1,411 @@
+/*
+* xtechnical_analysis - Technical analysis C++ library
+*
+* Copyright (c) 2018 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef XTECHNICAL_BATCH_INDICATORS_HPP_INCLUDED
+#define XTECHNICAL_BATCH_INDICATORS_HPP_INCLUDED
+
+#include "xtechnical_common.hpp"
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+#include <cmath>
+
+namespace xtechnical_indicators {
+    using namespace xtechnical_common;
+
+    /** \brief Простая скользящая средняя для группы символов
+     *
+     * Состояние num_symbols символов хранится в массивах структуры (SoA).
+     * Обновление делается в два прохода по символам: первый проход
+     * только считает, второй выбирает выход по готовности символа и
+     * заполняет флаги готовности. Выбор между вычисленными значениями
+     * GCC (при -ftrapping-math по умолчанию) оставляет ветвлением, а выбор
+     * между загруженными из памяти значениями и запись флагов через uint8_t
+     * в отдельном проходе векторизации не мешают, поэтому оба цикла
+     * векторизуются с -O3. Вместо кода INDICATOR_NOT_READY_TO_WORK
+     * для каждого символа заполняется флаг готовности. Результат совпадает
+     * с SMA для каждого символа
+     */
+    template <class T>
+    class SMABatch {
+    private:
+        std::vector<T> data_;           /**< кольцевой буфер, data_[slot * num_symbols_ + symbol] */
+        std::vector<T> sum_;
+        std::vector<uint32_t> count_;
+        size_t num_symbols_ = 0;
+        size_t period_ = 0;
+        size_t pos_ = 0;
+
+    public:
+        SMABatch() {};
+
+        /** \brief Инициализировать простую скользящую среднюю
+         * \param num_symbols количество символов
+         * \param period период
+         */
+        SMABatch(const size_t num_symbols, const size_t period) :
+            data_(num_symbols * period), sum_(num_symbols), count_(num_symbols),
+            num_symbols_(num_symbols), period_(period) {}
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигналы на входе, по одному на символ
+         * \param out сигналы на выходе (пока индикатор символа не готов, 0)
+         * \param is_ready флаги готовности индикатора символов (1 - готов)
+         * \return вернет 0, если готовы все символы, иначе см. ErrorType
+         */
+        int update(const T *in, T *out, uint8_t *is_ready) {
+            if(period_ == 0) return NO_INIT;
+            const size_t num_symbols = num_symbols_;
+            T *slot = data_.data() + pos_ * num_symbols;
+            T *sum = sum_.data();
+            uint32_t *count = count_.data();
+            const uint32_t period = (uint32_t)period_;
+            const T period_f = (T)period_;
+            for(size_t s = 0; s < num_symbols; ++s) {
+                const T value = in[s];
+                /* пока окно символа не заполнено, в его ячейках нули */
+                const T sum_value = sum[s] + (value - slot[s]);
+                sum[s] = sum_value;
+                slot[s] = value;
+                out[s] = sum_value / period_f;
+            }
+            size_t num_ready = 0;
+            for(size_t s = 0; s < num_symbols; ++s) {
+                const uint32_t next = std::min(count[s] + 1, period);
+                const bool ready = next >= period;
+                const T value = out[s];
+                count[s] = next;
+                out[s] = ready ? value : (T)0;
+                is_ready[s] = ready;
+                num_ready += ready;
+            }
+            pos_ = pos_ + 1 < period_ ? pos_ + 1 : 0;
+            return num_ready == num_symbols ? OK : INDICATOR_NOT_READY_TO_WORK;
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигналы на входе, размер num_symbols
+         * \param out сигналы на выходе, размер num_symbols
+         * \param is_ready флаги готовности, размер num_symbols
+         * \return вернет 0, если готовы все символы, иначе см. ErrorType
+         */
+        template <class T1, class T2, class T3>
+        int update(const T1 &in, T2 &out, T3 &is_ready) {
+            if(in.size() != num_symbols_ || out.size() != num_symbols_ ||
+                is_ready.size() != num_symbols_) return INVALID_PARAMETER;
+            return update(in.data(), out.data(), is_ready.data());
+        }
+
+        /** \brief Получить количество символов
+         */
+        inline size_t get_num_symbols() const {
+            return num_symbols_;
+        }
+
+        /** \brief Сбросить состояние одного символа
+         * \param symbol номер символа
+         */
+        void reset(const size_t symbol) {
+            if(symbol >= num_symbols_) return;
+            for(size_t i = 0; i < period_; ++i) {
+                data_[i * num_symbols_ + symbol] = 0;
+            }
+            sum_[symbol] = 0;
+            count_[symbol] = 0;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            std::fill(data_.begin(), data_.end(), (T)0);
+            std::fill(sum_.begin(), sum_.end(), (T)0);
+            std::fill(count_.begin(), count_.end(), (uint32_t)0);
+            pos_ = 0;
+        }
+    };
+
+    /** \brief Экспоненциально взвешенное скользящее среднее для группы символов
+     *
+     * Результат совпадает с EMA для каждого символа: первые period значений
+     * дают начальное среднее, после чего индикатор символа готов
+     */
+    template <class T>
+    class EMABatch {
+    protected:
+        std::vector<T> last_data_;
+        std::vector<T> sum_;
+        std::vector<uint32_t> count_;
+        size_t num_symbols_ = 0;
+        size_t period_ = 0;
+        T a_ = 0;
+
+    public:
+        EMABatch() {};
+
+        /** \brief Инициализировать экспоненциально взвешенное скользящее среднее
+         * \param num_symbols количество символов
+         * \param period период
+         */
+        EMABatch(const size_t num_symbols, const size_t period) :
+            last_data_(num_symbols), sum_(num_symbols), count_(num_symbols),
+            num_symbols_(num_symbols), period_(period) {
+            a_ = 2.0/(T)(period_ + 1.0);
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигналы на входе, по одному на символ
+         * \param out сигналы на выходе (пока индикатор символа не готов, равны входу),
+         * массив не должен совпадать с in
+         * \param is_ready флаги готовности индикатора символов (1 - готов)
+         * \return вернет 0, если готовы все символы, иначе см. ErrorType
+         */
+        int update(const T *in, T *out, uint8_t *is_ready) {
+            if(period_ == 0) return NO_INIT;
+            const size_t num_symbols = num_symbols_;
+            T *last_data = last_data_.data();
+            T *sum = sum_.data();
+            uint32_t *count = count_.data();
+            const uint32_t period = (uint32_t)period_;
+            const T period_f = (T)period_;
+            const T a = a_;
+            const T b = 1.0 - a_;
+            /* пока символ не готов, в last_data_ лежит среднее по накопленным
+             * значениям; после period значений это начальное значение EMA
+             */
+            for(size_t s = 0; s < num_symbols; ++s) {
+                const uint32_t c = count[s];
+                const T value = in[s];
+                const T add = c >= period ? (T)0 : value;
+                const T acc = sum[s] + add;
+                sum[s] = acc;
+                out[s] = a * value + b * last_data[s];
+                last_data[s] = acc / period_f;
+            }
+            size_t num_ready = 0;
+            for(size_t s = 0; s < num_symbols; ++s) {
+                const uint32_t c = count[s];
+                const bool ready = c >= period;
+                const T ema = out[s];
+                const T average = last_data[s];
+                const T value = in[s];
+                last_data[s] = ready ? ema : average;
+                out[s] = ready ? ema : value;
+                count[s] = std::min(c + 1, period);
+                is_ready[s] = ready;
+                num_ready += ready;
+            }
+            return num_ready == num_symbols ? OK : INDICATOR_NOT_READY_TO_WORK;
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигналы на входе, размер num_symbols
+         * \param out сигналы на выходе, размер num_symbols
+         * \param is_ready флаги готовности, размер num_symbols
+         * \return вернет 0, если готовы все символы, иначе см. ErrorType
+         */
+        template <class T1, class T2, class T3>
+        int update(const T1 &in, T2 &out, T3 &is_ready) {
+            if(in.size() != num_symbols_ || out.size() != num_symbols_ ||
+                is_ready.size() != num_symbols_) return INVALID_PARAMETER;
+            return update(in.data(), out.data(), is_ready.data());
+        }
+
+        /** \brief Получить количество символов
+         */
+        inline size_t get_num_symbols() const {
+            return num_symbols_;
+        }
+
+        /** \brief Сбросить состояние одного символа
+         * \param symbol номер символа
+         */
+        void reset(const size_t symbol) {
+            if(symbol >= num_symbols_) return;
+            last_data_[symbol] = 0;
+            sum_[symbol] = 0;
+            count_[symbol] = 0;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            std::fill(last_data_.begin(), last_data_.end(), (T)0);
+            std::fill(sum_.begin(), sum_.end(), (T)0);
+            std::fill(count_.begin(), count_.end(), (uint32_t)0);
+        }
+    };
+
+    /** \brief Модифицированное скользящее среднее для группы символов
+     */
+    template <class T>
+    class MMABatch : public EMABatch<T> {
+    public:
+        MMABatch() {};
+
+        /** \brief Инициализировать модифицированное скользящее среднее
+         * \param num_symbols количество символов
+         * \param period период
+         */
+        MMABatch(const size_t num_symbols, const size_t period) :
+            EMABatch<T>(num_symbols, period) {
+            EMABatch<T>::a_ = 1.0/(T)period;
+        }
+    };
+
+    /** \brief Индекс относительной силы для группы символов
+     *
+     * Результат совпадает с RSI<T,SMA<T>> для каждого символа
+     */
+    template <class T>
+    class RSIBatch {
+    private:
+        std::vector<T> data_u_;         /**< кольцевые буферы роста и падения, [slot * num_symbols_ + symbol] */
+        std::vector<T> data_d_;
+        std::vector<T> sum_u_;
+        std::vector<T> sum_d_;
+        std::vector<T> prev_;
+        std::vector<uint32_t> count_;   /**< 0 - нет цены, иначе 1 + число изменений цены в окне */
+        size_t num_symbols_ = 0;
+        size_t period_ = 0;
+        size_t pos_ = 0;
+
+    public:
+        RSIBatch() {};
+
+        /** \brief Инициализировать индикатор индекса относительной силы
+         * \param num_symbols количество символов
+         * \param period период индикатора
+         */
+        RSIBatch(const size_t num_symbols, const size_t period) :
+            data_u_(num_symbols * period), data_d_(num_symbols * period),
+            sum_u_(num_symbols), sum_d_(num_symbols), prev_(num_symbols),
+            count_(num_symbols), num_symbols_(num_symbols), period_(period) {}
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигналы на входе, по одному на символ
+         * \param out сигналы на выходе (пока индикатор символа не готов, 50)
+         * \param is_ready флаги готовности индикатора символов (1 - готов)
+         * \return вернет 0, если готовы все символы, иначе см. ErrorType
+         */
+        int update(const T *in, T *out, uint8_t *is_ready) {
+            if(period_ == 0) return NO_INIT;
+            const size_t num_symbols = num_symbols_;
+            T *slot_u = data_u_.data() + pos_ * num_symbols;
+            T *slot_d = data_d_.data() + pos_ * num_symbols;
+            T *sum_u = sum_u_.data();
+            T *sum_d = sum_d_.data();
+            T *prev = prev_.data();
+            uint32_t *count = count_.data();
+            const uint32_t full = (uint32_t)period_ + 1;
+            /* три коротких прохода вместо одного: в одном цикле было бы
+             * слишком много массивов, и GCC отказался бы от проверок
+             * пересечения массивов во время выполнения
+             */
+            for(size_t s = 0; s < num_symbols; ++s) {
+                const T value = in[s];
+                const T last = prev[s];
+                /* на первой цене символа изменения цены еще нет */
+                const T base = count[s] > 0 ? last : value;
+                out[s] = value - base;
+                prev[s] = value;
+            }
+            for(size_t s = 0; s < num_symbols; ++s) {
+                const T diff = out[s];
+                /* рост и падение без ветвлений, оба выражения точные */
+                const T u = (std::abs(diff) + diff) * (T)0.5;
+                const T d = (std::abs(diff) - diff) * (T)0.5;
+                /* пока окно символа не заполнено, в его ячейках нули */
+                const T mu = sum_u[s] + (u - slot_u[s]);
+                const T md = sum_d[s] + (d - slot_d[s]);
+                sum_u[s] = mu;
+                sum_d[s] = md;
+                slot_u[s] = u;
+                slot_d[s] = d;
+                /* при md == 0 здесь inf или nan, третий проход заменит их на 100 */
+                out[s] = (T)(100.0 - (100.0 / (1.0 + mu / md)));
+            }
+            size_t num_ready = 0;
+            for(size_t s = 0; s < num_symbols; ++s) {
+                const uint32_t next = std::min(count[s] + 1, full);
+                const bool ready = next >= full;
+                const T rsi = out[s];
+                const T md = sum_d[s];
+                out[s] = ready ? (md == 0 ? (T)100.0 : rsi) : (T)50.0;
+                count[s] = next;
+                is_ready[s] = ready;
+                num_ready += ready;
+            }
+            pos_ = pos_ + 1 < period_ ? pos_ + 1 : 0;
+            return num_ready == num_symbols ? OK : INDICATOR_NOT_READY_TO_WORK;
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигналы на входе, размер num_symbols
+         * \param out сигналы на выходе, размер num_symbols
+         * \param is_ready флаги готовности, размер num_symbols
+         * \return вернет 0, если готовы все символы, иначе см. ErrorType
+         */
+        template <class T1, class T2, class T3>
+        int update(const T1 &in, T2 &out, T3 &is_ready) {
+            if(in.size() != num_symbols_ || out.size() != num_symbols_ ||
+                is_ready.size() != num_symbols_) return INVALID_PARAMETER;
+            return update(in.data(), out.data(), is_ready.data());
+        }
+
+        /** \brief Получить количество символов
+         */
+        inline size_t get_num_symbols() const {
+            return num_symbols_;
+        }
+
+        /** \brief Сбросить состояние одного символа
+         * \param symbol номер символа
+         */
+        void reset(const size_t symbol) {
+            if(symbol >= num_symbols_) return;
+            for(size_t i = 0; i < period_; ++i) {
+                data_u_[i * num_symbols_ + symbol] = 0;
+                data_d_[i * num_symbols_ + symbol] = 0;
+            }
+            sum_u_[symbol] = 0;
+            sum_d_[symbol] = 0;
+            prev_[symbol] = 0;
+            count_[symbol] = 0;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            std::fill(data_u_.begin(), data_u_.end(), (T)0);
+            std::fill(data_d_.begin(), data_d_.end(), (T)0);
+            std::fill(sum_u_.begin(), sum_u_.end(), (T)0);
+            std::fill(sum_d_.begin(), sum_d_.end(), (T)0);
+            std::fill(prev_.begin(), prev_.end(), (T)0);
+            std::fill(count_.begin(), count_.end(), (uint32_t)0);
+            pos_ = 0;
+        }
+    };
+}
+
+#endif // XTECHNICAL_BATCH_INDICATORS_HPP_INCLUDED
@@ -51,6 +51,11 @@ namespace xtechnical_common {
         BUY = 1,
         SELL = -1,
     };
+
+    /// Размер линии кэша, по нему разделяются данные разных потоков
+    enum {
+        CACHE_LINE_SIZE = 64,
+    };
 };
 
 #endif // XTECHNICAL_COMMON_HPP_INCLUDED
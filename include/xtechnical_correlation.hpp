@@ -25,12 +25,16 @@
 #define XTECHNICAL_CORRELATION_HPP_INCLUDED
 
 #include "xtechnical_common.hpp"
+#include "xtechnical_dft.hpp"
 
 #include <vector>
 #include <algorithm>
 #include <numeric>
 #include <limits>
 #include <cmath>
+#include <thread>
+#include <atomic>
+#include <cstdint>
 
 namespace xtechnical_correlation {
     using namespace xtechnical_common;
@@ -67,6 +71,473 @@ namespace xtechnical_correlation {
         return OK;
     }
 
+    /** \brief Скользящий коэффициент корреляции Пирсона
+     *
+     * Класс хранит парный кольцевой буфер и суммы Σx, Σy, Σx², Σy², Σxy,
+     * поэтому обновление и чтение коэффициента выполняются за O(1).
+     * Для борьбы с накоплением ошибки суммы считаются относительно опорных
+     * значений и периодически пересчитываются заново по буферу.
+     */
+    template<class T>
+    class RollingPearson {
+    private:
+        std::vector<T> data_x_;
+        std::vector<T> data_y_;
+        size_t period_ = 0;
+        size_t pos_ = 0;
+        size_t count_ = 0;
+        size_t recalc_period_ = 0;
+        size_t num_updates_ = 0;
+        T ref_x_ = 0, ref_y_ = 0;
+        T sx_ = 0, sy_ = 0, sxx_ = 0, syy_ = 0, sxy_ = 0;
+        T rxy_ = 0;
+        T rxy_test_ = 0;
+        int err_ = NO_INIT;
+        int err_test_ = NO_INIT;
+        bool is_test_ = false;
+
+        int calc_correlation(
+                const T sx,
+                const T sy,
+                const T sxx,
+                const T syy,
+                const T sxy,
+                T &rxy) const {
+            const T n = (T)period_;
+            const T cov = n * sxy - sx * sy;
+            const T var_x = n * sxx - sx * sx;
+            const T var_y = n * syy - sy * sy;
+            if(var_x <= 0 || var_y <= 0) return INVALID_PARAMETER;
+            rxy = cov / std::sqrt(var_x * var_y);
+            if(rxy > 1) rxy = 1;
+            else if(rxy < -1) rxy = -1;
+            return OK;
+        }
+
+        void recalc_sums() {
+            ref_x_ = data_x_[pos_];
+            ref_y_ = data_y_[pos_];
+            sx_ = sy_ = sxx_ = syy_ = sxy_ = 0;
+            for(size_t i = 0; i < period_; ++i) {
+                const T dx = data_x_[i] - ref_x_;
+                const T dy = data_y_[i] - ref_y_;
+                sx_ += dx;
+                sy_ += dy;
+                sxx_ += dx * dx;
+                syy_ += dy * dy;
+                sxy_ += dx * dy;
+            }
+            num_updates_ = 0;
+        }
+    public:
+        RollingPearson() {};
+
+        /** \brief Инициализировать скользящую корреляцию Пирсона
+         * \param period период
+         * \param recalc_period период полного пересчета сумм
+         * (0 - пересчитывать каждые period обновлений)
+         */
+        RollingPearson(const size_t period, const size_t recalc_period = 0) :
+                period_(period),
+                recalc_period_(recalc_period == 0 ? period : recalc_period) {
+            data_x_.resize(period_);
+            data_y_.resize(period_);
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T x, const T y) {
+            is_test_ = false;
+            if(period_ < 2) return NO_INIT;
+            if(count_ < period_) {
+                data_x_[pos_] = x;
+                data_y_[pos_] = y;
+                pos_ = (pos_ + 1) % period_;
+                ++count_;
+                if(count_ < period_) {
+                    err_ = INDICATOR_NOT_READY_TO_WORK;
+                    return err_;
+                }
+                recalc_sums();
+            } else {
+                const T old_dx = data_x_[pos_] - ref_x_;
+                const T old_dy = data_y_[pos_] - ref_y_;
+                const T dx = x - ref_x_;
+                const T dy = y - ref_y_;
+                sx_ += dx - old_dx;
+                sy_ += dy - old_dy;
+                sxx_ += dx * dx - old_dx * old_dx;
+                syy_ += dy * dy - old_dy * old_dy;
+                sxy_ += dx * dy - old_dx * old_dy;
+                data_x_[pos_] = x;
+                data_y_[pos_] = y;
+                pos_ = (pos_ + 1) % period_;
+                if(++num_updates_ >= recalc_period_) recalc_sums();
+            }
+            err_ = calc_correlation(sx_, sy_, sxx_, syy_, sxy_, rxy_);
+            return err_;
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \param rxy коэффициент корреляции Пирсона (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T x, const T y, T &rxy) {
+            int err = update(x, y);
+            rxy = err == OK ? rxy_ : 0;
+            return err;
+        }
+
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем, что не влияет на внутреннее
+         * состояние индикатора (например, для расчета по формирующемуся бару)
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \param rxy коэффициент корреляции Пирсона (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int test(const T x, const T y, T &rxy) {
+            is_test_ = true;
+            rxy = 0;
+            if(period_ < 2) {
+                err_test_ = NO_INIT;
+                return err_test_;
+            }
+            if(count_ + 1 < period_) {
+                err_test_ = INDICATOR_NOT_READY_TO_WORK;
+                return err_test_;
+            }
+            T sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+            if(count_ < period_) {
+                /* буфер заполняется этим значением впервые */
+                const T rx = data_x_[0];
+                const T ry = data_y_[0];
+                for(size_t i = 0; i < count_; ++i) {
+                    const T dx = data_x_[i] - rx;
+                    const T dy = data_y_[i] - ry;
+                    sx += dx;
+                    sy += dy;
+                    sxx += dx * dx;
+                    syy += dy * dy;
+                    sxy += dx * dy;
+                }
+                const T dx = x - rx;
+                const T dy = y - ry;
+                sx += dx;
+                sy += dy;
+                sxx += dx * dx;
+                syy += dy * dy;
+                sxy += dx * dy;
+            } else {
+                const T old_dx = data_x_[pos_] - ref_x_;
+                const T old_dy = data_y_[pos_] - ref_y_;
+                const T dx = x - ref_x_;
+                const T dy = y - ref_y_;
+                sx = sx_ + dx - old_dx;
+                sy = sy_ + dy - old_dy;
+                sxx = sxx_ + dx * dx - old_dx * old_dx;
+                syy = syy_ + dy * dy - old_dy * old_dy;
+                sxy = sxy_ + dx * dy - old_dx * old_dy;
+            }
+            err_test_ = calc_correlation(sx, sy, sxx, syy, sxy, rxy_test_);
+            if(err_test_ == OK) rxy = rxy_test_;
+            return err_test_;
+        }
+
+        /** \brief Получить коэффициент корреляции
+         *
+         * Вернет результат последнего вызова update или test
+         * \param rxy коэффициент корреляции Пирсона (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int get_correlation(T &rxy) const {
+            if(is_test_) {
+                rxy = rxy_test_;
+                return err_test_;
+            }
+            rxy = rxy_;
+            return err_;
+        }
+
+        /** \brief Проверить заполнение буфера
+         * \return Вернет true, если буфер полностью заполнен
+         */
+        bool is_init() const {
+            return period_ >= 2 && count_ == period_;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            pos_ = 0;
+            count_ = 0;
+            num_updates_ = 0;
+            ref_x_ = ref_y_ = 0;
+            sx_ = sy_ = sxx_ = syy_ = sxy_ = 0;
+            rxy_ = rxy_test_ = 0;
+            err_ = err_test_ = NO_INIT;
+            is_test_ = false;
+        }
+    };
+
+    /** \brief Скользящая матрица корреляции Пирсона для N символов
+     *
+     * Окна всех символов хранятся в одном кольцевом буфере строк
+     * (строка - синхронный срез цен всех символов), а матрица сумм
+     * произведений Σxi*xj обновляется инкрементально при поступлении
+     * новой строки за O(N²). Внутренний цикл идет по непрерывной памяти
+     * и векторизуется компилятором.
+     * Может заменить попарный расчет в CurrencyCorrelation, если цены
+     * символов поступают синхронно.
+     */
+    template<class T>
+    class CorrelationMatrix {
+    private:
+        std::vector<T> data_;       ///< Кольцевой буфер строк, period x N
+        std::vector<T> ref_;        ///< Опорные значения символов
+        std::vector<T> sum_;        ///< Σxi
+        std::vector<T> sum_prod_;   ///< Σxi*xj, верхний треугольник N x N
+        std::vector<T> row_;
+        std::vector<T> test_row_;
+        size_t period_ = 0;
+        size_t num_symbols_ = 0;
+        size_t pos_ = 0;
+        size_t count_ = 0;
+        size_t recalc_period_ = 0;
+        size_t num_updates_ = 0;
+        bool is_test_ = false;
+
+        void recalc_sums() {
+            const size_t n = num_symbols_;
+            const T *first = &data_[pos_ * n];
+            std::copy(first, first + n, ref_.begin());
+            std::fill(sum_.begin(), sum_.end(), T(0));
+            std::fill(sum_prod_.begin(), sum_prod_.end(), T(0));
+            for(size_t k = 0; k < period_; ++k) {
+                const T *src = &data_[k * n];
+                for(size_t s = 0; s < n; ++s) {
+                    row_[s] = src[s] - ref_[s];
+                }
+                add_row(row_.data(), T(1));
+            }
+            num_updates_ = 0;
+        }
+
+        inline void add_row(const T *row, const T sign) {
+            const size_t n = num_symbols_;
+            for(size_t i = 0; i < n; ++i) {
+                const T ri = sign * row[i];
+                sum_[i] += ri;
+                T *dst = &sum_prod_[i * n];
+                for(size_t j = i; j < n; ++j) {
+                    dst[j] += ri * row[j];
+                }
+            }
+        }
+
+        inline void calc_moments(
+                const size_t i,
+                const size_t j,
+                T &si,
+                T &sj,
+                T &sii,
+                T &sjj,
+                T &sij) const {
+            const size_t n = num_symbols_;
+            si = sum_[i];
+            sj = sum_[j];
+            sii = sum_prod_[i * n + i];
+            sjj = sum_prod_[j * n + j];
+            sij = sum_prod_[i * n + j];
+            if(!is_test_) return;
+            /* в режиме теста применяем поправку от новой строки без изменения сумм */
+            const T *old_row = &data_[pos_ * n];
+            const T nxi = test_row_[i] - ref_[i], nxj = test_row_[j] - ref_[j];
+            const T oxi = old_row[i] - ref_[i], oxj = old_row[j] - ref_[j];
+            si += nxi - oxi;
+            sj += nxj - oxj;
+            sii += nxi * nxi - oxi * oxi;
+            sjj += nxj * nxj - oxj * oxj;
+            sij += nxi * nxj - oxi * oxj;
+        }
+    public:
+        CorrelationMatrix() {};
+
+        /** \brief Инициализировать матрицу корреляции
+         * \param period период
+         * \param num_symbols количество символов
+         * \param recalc_period период полного пересчета сумм
+         * (0 - пересчитывать каждые period обновлений)
+         */
+        CorrelationMatrix(
+                const size_t period,
+                const size_t num_symbols,
+                const size_t recalc_period = 0) :
+                period_(period),
+                num_symbols_(num_symbols),
+                recalc_period_(recalc_period == 0 ? period : recalc_period) {
+            data_.resize(period_ * num_symbols_);
+            ref_.resize(num_symbols_);
+            sum_.resize(num_symbols_);
+            sum_prod_.resize(num_symbols_ * num_symbols_);
+            row_.resize(num_symbols_);
+            test_row_.resize(num_symbols_);
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in синхронный срез цен всех символов
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template<class T1>
+        int update(const T1 &in) {
+            is_test_ = false;
+            if(period_ < 2 || num_symbols_ == 0) return NO_INIT;
+            if(in.size() != num_symbols_) return INVALID_PARAMETER;
+            const size_t n = num_symbols_;
+            T *dst = &data_[pos_ * n];
+            if(count_ < period_) {
+                for(size_t s = 0; s < n; ++s) dst[s] = in[s];
+                pos_ = (pos_ + 1) % period_;
+                if(++count_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+                recalc_sums();
+                return OK;
+            }
+            for(size_t s = 0; s < n; ++s) row_[s] = dst[s] - ref_[s];
+            add_row(row_.data(), T(-1));
+            for(size_t s = 0; s < n; ++s) {
+                dst[s] = in[s];
+                row_[s] = dst[s] - ref_[s];
+            }
+            add_row(row_.data(), T(1));
+            pos_ = (pos_ + 1) % period_;
+            if(++num_updates_ >= recalc_period_) recalc_sums();
+            return OK;
+        }
+
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем, что не влияет на внутреннее
+         * состояние индикатора. Последующие вызовы get_correlation,
+         * get_matrix и find_correlated_pairs учитывают тестовую строку
+         * до следующего вызова update.
+         * \param in синхронный срез цен всех символов
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template<class T1>
+        int test(const T1 &in) {
+            is_test_ = false;
+            if(period_ < 2 || num_symbols_ == 0) return NO_INIT;
+            if(in.size() != num_symbols_) return INVALID_PARAMETER;
+            if(count_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+            for(size_t s = 0; s < num_symbols_; ++s) test_row_[s] = in[s];
+            is_test_ = true;
+            return OK;
+        }
+
+        /** \brief Проверить заполнение буфера
+         * \return Вернет true, если буфер полностью заполнен
+         */
+        bool is_init() const {
+            return period_ >= 2 && count_ == period_;
+        }
+
+        /** \brief Посчитать корреляцию между двумя символами
+         * \param out значение корреляции
+         * \param num_symbol_1 номер первого символа
+         * \param num_symbol_2 номер второго символа
+         * \return состояние ошибки, 0 в случае успеха
+         */
+        int get_correlation(
+                T &out,
+                const size_t num_symbol_1,
+                const size_t num_symbol_2) const {
+            if(period_ < 2 || num_symbols_ == 0) return NO_INIT;
+            if(count_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+            if(num_symbol_1 >= num_symbols_ ||
+                num_symbol_2 >= num_symbols_) return INVALID_PARAMETER;
+            size_t i = num_symbol_1, j = num_symbol_2;
+            if(i > j) std::swap(i, j);
+            T si, sj, sii, sjj, sij;
+            calc_moments(i, j, si, sj, sii, sjj, sij);
+            const T n = (T)period_;
+            const T var_i = n * sii - si * si;
+            const T var_j = n * sjj - sj * sj;
+            if(var_i <= 0 || var_j <= 0) return INVALID_PARAMETER;
+            out = (n * sij - si * sj) / std::sqrt(var_i * var_j);
+            if(out > 1) out = 1;
+            else if(out < -1) out = -1;
+            return OK;
+        }
+
+        /** \brief Получить полную матрицу корреляции
+         * \param out матрица N x N в построчном порядке.
+         * Для символов с нулевой дисперсией коэффициент равен 0
+         * \return состояние ошибки, 0 в случае успеха
+         */
+        int get_matrix(std::vector<T> &out) const {
+            if(period_ < 2 || num_symbols_ == 0) return NO_INIT;
+            if(count_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+            const size_t n = num_symbols_;
+            out.resize(n * n);
+            for(size_t i = 0; i < n; ++i) {
+                out[i * n + i] = 1;
+                for(size_t j = i + 1; j < n; ++j) {
+                    T coeff = 0;
+                    if(get_correlation(coeff, i, j) != OK) coeff = 0;
+                    out[i * n + j] = coeff;
+                    out[j * n + i] = coeff;
+                }
+            }
+            return OK;
+        }
+
+        /** \brief Найти коррелирующие символы
+         * \param symbol_1 список первых символов в коррелирующей паре
+         * \param symbol_2 список вторых символов в коррелирующей паре
+         * \param coefficient список коэффициентов корреляции
+         * \param threshold_coefficient порог срабатывания
+         * для коэффициента корреляции
+         */
+        void find_correlated_pairs(
+                std::vector<size_t> &symbol_1,
+                std::vector<size_t> &symbol_2,
+                std::vector<T> &coefficient,
+                const T threshold_coefficient) const {
+            symbol_1.clear();
+            symbol_2.clear();
+            coefficient.clear();
+            if(count_ < period_ || num_symbols_ == 0) return;
+            for(size_t i = 0; i < num_symbols_ - 1; ++i) {
+                for(size_t j = i + 1; j < num_symbols_; ++j) {
+                    T coeff = 0;
+                    if(get_correlation(coeff, i, j) != OK) continue;
+                    if(std::abs(coeff) > threshold_coefficient) {
+                        symbol_1.push_back(i);
+                        symbol_2.push_back(j);
+                        coefficient.push_back(coeff);
+                    }
+                }
+            }
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            pos_ = 0;
+            count_ = 0;
+            num_updates_ = 0;
+            is_test_ = false;
+            std::fill(sum_.begin(), sum_.end(), T(0));
+            std::fill(sum_prod_.begin(), sum_prod_.end(), T(0));
+        }
+    };
+
     /** \brief Ранжирование для корреляции Спирмена
      * \param x вектор данных
      * \param xp ранги
@@ -143,12 +614,78 @@ namespace xtechnical_correlation {
         return (T1)(size * size * size - size) / (T1)12.0;
     }
 
+    /** \brief Ранги выборки для корреляции Спирмена
+     *
+     * Делает то же, что calculate_spearmen_ranking, calculate_repetitions_rank
+     * и calculate_reshaping_ranks вместе, но за одну сортировку.
+     * Одинаковым значениям присваивается средний ранг.
+     * \param x указатель на данные
+     * \param size размер выборки
+     * \param xp ранги
+     * \param index временный буфер индексов (чтобы не выделять память при повторных вызовах)
+     * \return поправка на одинаковые ранги (0, если повторов нет)
+     */
+    template<typename T1, typename T2>
+    T2 calculate_spearman_ranks(
+            const T1 *x,
+            const size_t size,
+            std::vector<T2> &xp,
+            std::vector<size_t> &index) {
+        index.resize(size);
+        xp.resize(size);
+        for(size_t i = 0; i < size; ++i) index[i] = i;
+        std::sort(index.begin(), index.end(), [x](const size_t a, const size_t b) {
+            return x[a] < x[b];
+        });
+        int num_repetitions = 0;
+        size_t i = 0;
+        while(i < size) {
+            size_t j = i + 1;
+            while(j < size && x[index[j]] == x[index[i]]) ++j;
+            const size_t group_size = j - i;
+            num_repetitions += (int)(group_size * (group_size - 1) / 2);
+            const T2 rank = (T2)(i + j + 1) / (T2)2;
+            for(size_t k = i; k < j; ++k) xp[index[k]] = rank;
+            i = j;
+        }
+        if(num_repetitions == 0) return T2(0);
+        return calculate_spearman_check_sum<T2>(num_repetitions);
+    }
+
+    /** \brief Коэффициент корреляции Спирмена по готовым рангам
+     * \param rx ранги первой выборки (см. calculate_spearman_ranks)
+     * \param d1 поправка на одинаковые ранги первой выборки
+     * \param ry ранги второй выборки
+     * \param d2 поправка на одинаковые ранги второй выборки
+     * \return коэффициент корреляции Спирмена
+     */
+    template<class T1>
+    T1 calculate_spearman_coefficient_from_ranks(
+            const std::vector<T1> &rx,
+            const T1 d1,
+            const std::vector<T1> &ry,
+            const T1 d2) {
+        T1 sum = 0;
+        const size_t size = rx.size();
+        for(size_t i = 0; i < size; ++i) {
+            T1 diff = rx[i] - ry[i];
+            sum += diff * diff;
+        }
+        T1 n = size;
+        return 1.0 - ((6.0 *  sum + d1 + d2)/(n * n * n - n));
+    }
+
     /** \brief Коэффициент корреляции Спирмена
      * Коэффициент корреляции Спирмена - мера линейной связи между случайными величинами.
      * Корреляция Спирмена является ранговой, то есть для оценки силы связи используются не численные значения, а соответствующие им ранги.
      * Коэффициент инвариантен по отношению к любому монотонному преобразованию шкалы измерения.
      * Ссылка на материал про коэффициент Спирмена
      * https://math.semestr.ru/corel/spirmen.php
+     *
+     * Считается по формуле 1 - 6*Σd²/(n³ - n) с поправкой на одинаковые ранги.
+     * Без повторов результат совпадает с корреляцией Пирсона рангов, которую
+     * считают calculate_correlation_matrix (SPEARMAN_RANK_CORRELATION) и
+     * RollingSpearman. При повторах значения отличаются
      * \param x первая выборка данных
      * \param y вторая выборка данных
      * \param p коэффициент корреляции Спирмена (от -1 до +1)
@@ -160,43 +697,874 @@ namespace xtechnical_correlation {
             return INVALID_PARAMETER;
         }
         // найдем ранги элементов
-        std::vector<T3> rx(x.size());
-        std::vector<T3> ry(y.size());
-        calculate_spearmen_ranking(x, rx);
-        calculate_spearmen_ranking(y, ry);
+        std::vector<T3> rx, ry;
+        std::vector<size_t> index;
+        const T3 d1 = calculate_spearman_ranks(x.data(), x.size(), rx, index);
+        const T3 d2 = calculate_spearman_ranks(y.data(), y.size(), ry, index);
+        p = calculate_spearman_coefficient_from_ranks(rx, d1, ry, d2);
+        return OK;
+    }
 
-        int rep_x = calculate_repetitions_rank(rx);
-        int rep_y = calculate_repetitions_rank(ry);
+    /// Типы корреляции для пакетного расчета матрицы
+    enum {
+        SPEARMAN_RANK_CORRELATION = 0,  ///< Ранговая корреляция Спирмена
+        PEARSON_CORRELATION = 1,        ///< Корреляция Пирсона
+    };
 
-        T3 d1 = 0.0, d2 = 0.0;
-        if(rep_x > 0) {
-            d1 = calculate_spearman_check_sum<T3>(rep_x);
-            T3 sum = std::accumulate(rx.begin(), rx.end(), T3(0));
-            T3 calc_sum = (((T3)rx.size() + 1.0) * (T3)rx.size()) / 2.0;
-            if(sum != calc_sum) {
-                calculate_reshaping_ranks(rx);
+    /** \brief Дробные ранги выборки
+     * Одинаковым значениям присваивается средний ранг (см. calculate_spearman_ranks)
+     * \param x вектор данных
+     * \param xp ранги (от 1 до x.size())
+     */
+    template<typename T1, typename T2>
+    void calculate_fractional_ranking(const std::vector<T1> &x, std::vector<T2> &xp) {
+        std::vector<size_t> index;
+        calculate_spearman_ranks(x.data(), x.size(), xp, index);
+    }
+
+    /** \brief Индекс элемента (i, j), i < j, в упакованном верхнем треугольнике
+     * матрицы размером n x n без главной диагонали (построчно)
+     * \param i строка
+     * \param j столбец
+     * \param n размер матрицы
+     * \return индекс в упакованном массиве
+     */
+    inline size_t get_packed_triangle_index(const size_t i, const size_t j, const size_t n) {
+        return i * (2 * n - i - 1) / 2 + (j - i - 1);
+    }
+
+    /** \brief Скалярное произведение с несколькими аккумуляторами
+     *
+     * Независимые частичные суммы позволяют компилятору
+     * использовать SIMD без изменения порядка сложения
+     */
+    template<class T>
+    inline T calculate_dot_product(const T *a, const T *b, const size_t size) {
+        T acc[8] = {0,0,0,0,0,0,0,0};
+        size_t k = 0;
+        for(; k + 8 <= size; k += 8) {
+            for(size_t l = 0; l < 8; ++l) {
+                acc[l] += a[k + l] * b[k + l];
             }
         }
-        if(rep_y > 0) {
-            d2 = calculate_spearman_check_sum<T3>(rep_y);
-            T3 sum = std::accumulate(ry.begin(), ry.end(), T3(0));
-            T3 calc_sum = (((T3)ry.size() + 1.0) * (T3)ry.size()) / 2.0;
-            if(sum != calc_sum) {
-                calculate_reshaping_ranks(ry);
+        T sum = ((acc[0] + acc[4]) + (acc[1] + acc[5])) +
+            ((acc[2] + acc[6]) + (acc[3] + acc[7]));
+        for(; k < size; ++k) sum += a[k] * b[k];
+        return sum;
+    }
+
+    /** \brief Посчитать матрицу корреляции для большого числа инструментов
+     *
+     * Каждая выборка один раз стандартизируется (для корреляции Спирмена
+     * предварительно заменяется дробными рангами, поэтому при одинаковых
+     * значениях коэффициенты отличаются от calculate_spearman_rank_correlation_coefficient),
+     * после чего матрица считается
+     * как произведение Z*Z' блоками, помещающимися в кэш.
+     * Блоки распределяются между потоками.
+     * Для выборок с нулевой дисперсией коэффициенты равны 0.
+     * \param data выборки данных, все одинаковой длины
+     * \param packed упакованный верхний треугольник матрицы без диагонали,
+     * размер n*(n-1)/2, см. get_packed_triangle_index
+     * \param correlation_type тип корреляции (SPEARMAN_RANK_CORRELATION, PEARSON_CORRELATION)
+     * \param num_threads количество потоков (0 - по числу ядер, не меньше 1)
+     * \return вернет 0 в случае успеха, иначе см. ErrorType
+     */
+    template<class T1, class T2>
+    int calculate_correlation_matrix(
+            const std::vector<std::vector<T1>> &data,
+            std::vector<T2> &packed,
+            const int correlation_type = PEARSON_CORRELATION,
+            size_t num_threads = 0) {
+        const size_t num_series = data.size();
+        if(num_series < 2) return INVALID_PARAMETER;
+        const size_t len = data[0].size();
+        if(len < 2) return INVALID_PARAMETER;
+        for(size_t s = 1; s < num_series; ++s) {
+            if(data[s].size() != len) return INVALID_PARAMETER;
+        }
+        if(correlation_type != PEARSON_CORRELATION &&
+            correlation_type != SPEARMAN_RANK_CORRELATION)
+            return INVALID_PARAMETER;
+
+        /* стандартизация: z = (x - mean) / sqrt(Σ(x - mean)²) */
+        std::vector<double> z(num_series * len);
+        std::vector<double> ranks;
+        std::vector<size_t> index;
+        for(size_t s = 0; s < num_series; ++s) {
+            double *dst = &z[s * len];
+            if(correlation_type == SPEARMAN_RANK_CORRELATION) {
+                calculate_spearman_ranks(data[s].data(), len, ranks, index);
+                std::copy(ranks.begin(), ranks.end(), dst);
+            } else {
+                for(size_t k = 0; k < len; ++k) dst[k] = data[s][k];
             }
+            double mean = 0;
+            for(size_t k = 0; k < len; ++k) mean += dst[k];
+            mean /= (double)len;
+            double sum = 0;
+            for(size_t k = 0; k < len; ++k) {
+                dst[k] -= mean;
+                sum += dst[k] * dst[k];
+            }
+            const double norm = sum > 0 ? 1.0 / std::sqrt(sum) : 0.0;
+            for(size_t k = 0; k < len; ++k) dst[k] *= norm;
         }
 
-        T3 sum = 0;
-        for(size_t i = 0; i < x.size(); ++i) {
-            T3 diff = rx[i] - ry[i];
-            sum += diff * diff;
+        packed.resize(num_series * (num_series - 1) / 2);
+
+        /* блоки строк по BLOCK_SIZE выборок, длина - по BLOCK_LEN отсчетов */
+        const size_t BLOCK_SIZE = 32;
+        const size_t BLOCK_LEN = 512;
+        const size_t num_blocks = (num_series + BLOCK_SIZE - 1) / BLOCK_SIZE;
+        const size_t num_tiles = num_blocks * (num_blocks + 1) / 2;
+
+        if(num_threads == 0) num_threads = std::thread::hardware_concurrency();
+        num_threads = std::max(std::min(num_threads, num_tiles), (size_t)1);
+
+        /* память плиток выделяется заранее, чтобы потоки не бросали исключений */
+        const size_t TILE_SIZE = BLOCK_SIZE * BLOCK_SIZE;
+        std::vector<double> tiles(num_threads * TILE_SIZE);
+        std::atomic<size_t> next_tile(0);
+        auto worker = [&](double *tile) {
+            size_t t;
+            while((t = next_tile.fetch_add(1)) < num_tiles) {
+                /* номер плитки -> (bi, bj), bi <= bj */
+                size_t bi = 0, row_tiles = num_blocks;
+                while(t >= row_tiles) {
+                    t -= row_tiles;
+                    --row_tiles;
+                    ++bi;
+                }
+                const size_t bj = bi + t;
+                const size_t i_beg = bi * BLOCK_SIZE;
+                const size_t i_end = std::min(i_beg + BLOCK_SIZE, num_series);
+                const size_t j_beg = bj * BLOCK_SIZE;
+                const size_t j_end = std::min(j_beg + BLOCK_SIZE, num_series);
+                std::fill(tile, tile + TILE_SIZE, 0.0);
+                for(size_t k_beg = 0; k_beg < len; k_beg += BLOCK_LEN) {
+                    const size_t k_len = std::min(BLOCK_LEN, len - k_beg);
+                    for(size_t i = i_beg; i < i_end; ++i) {
+                        const double *zi = &z[i * len + k_beg];
+                        const size_t j_start = std::max(j_beg, i + 1);
+                        for(size_t j = j_start; j < j_end; ++j) {
+                            tile[(i - i_beg) * BLOCK_SIZE + (j - j_beg)] +=
+                                calculate_dot_product(zi, &z[j * len + k_beg], k_len);
+                        }
+                    }
+                }
+                for(size_t i = i_beg; i < i_end; ++i) {
+                    const size_t j_start = std::max(j_beg, i + 1);
+                    for(size_t j = j_start; j < j_end; ++j) {
+                        double r = tile[(i - i_beg) * BLOCK_SIZE + (j - j_beg)];
+                        if(r > 1.0) r = 1.0;
+                        else if(r < -1.0) r = -1.0;
+                        packed[get_packed_triangle_index(i, j, num_series)] = (T2)r;
+                    }
+                }
+            }
+        };
+
+        /* если поток не удалось создать, запущенные потоки останавливаются после текущей плитки
+         * и присоединяются, иначе деструктор std::thread вызвал бы std::terminate
+         */
+        std::vector<std::thread> threads;
+        try {
+            threads.reserve(num_threads - 1);
+            for(size_t n = 1; n < num_threads; ++n) {
+                threads.emplace_back(worker, &tiles[n * TILE_SIZE]);
+            }
+        } catch(...) {
+            next_tile.store(num_tiles);
+            for(size_t n = 0; n < threads.size(); ++n) threads[n].join();
+            throw;
+        }
+        worker(&tiles[0]);
+        for(size_t n = 0; n < threads.size(); ++n) threads[n].join();
+        return OK;
+    }
+
+    /** \brief Найти коррелирующие пары по упакованной матрице корреляции
+     * \param packed упакованный верхний треугольник матрицы (см. calculate_correlation_matrix)
+     * \param num_series количество выборок
+     * \param symbol_1 список первых выборок в коррелирующей паре
+     * \param symbol_2 список вторых выборок в коррелирующей паре
+     * \param coefficient список коэффициентов корреляции
+     * \param threshold_coefficient порог срабатывания для коэффициента корреляции
+     * \return вернет 0 в случае успеха, иначе см. ErrorType
+     */
+    template<class T1, class T2>
+    int find_correlated_pairs(
+            const std::vector<T1> &packed,
+            const size_t num_series,
+            std::vector<size_t> &symbol_1,
+            std::vector<size_t> &symbol_2,
+            std::vector<T2> &coefficient,
+            const T2 threshold_coefficient) {
+        symbol_1.clear();
+        symbol_2.clear();
+        coefficient.clear();
+        if(num_series < 2 || packed.size() != num_series * (num_series - 1) / 2)
+            return INVALID_PARAMETER;
+        size_t index = 0;
+        for(size_t i = 0; i < num_series - 1; ++i) {
+            for(size_t j = i + 1; j < num_series; ++j, ++index) {
+                if(std::abs(packed[index]) > threshold_coefficient) {
+                    symbol_1.push_back(i);
+                    symbol_2.push_back(j);
+                    coefficient.push_back(packed[index]);
+                }
+            }
+        }
+        return OK;
+    }
+
+    /** \brief Скользящий коэффициент ранговой корреляции Спирмена
+     *
+     * Значения каждой выборки хранятся в упорядоченном массиве,
+     * поэтому ранг нового значения находится бинарным поиском за O(log n).
+     * Ранги остальных элементов окна при вытеснении старого и добавлении
+     * нового значения меняются не более чем на 1, поэтому они и суммы
+     * для коэффициента обновляются одним проходом по окну без сортировки
+     * и выделения памяти. Одинаковым значениям присваивается средний ранг,
+     * коэффициент считается как корреляция Пирсона рангов.
+     */
+    template<class T>
+    class RollingSpearman {
+    private:
+        std::vector<T> data_x_;
+        std::vector<T> data_y_;
+        std::vector<T> rank_x_;
+        std::vector<T> rank_y_;
+        std::vector<T> sorted_x_;
+        std::vector<T> sorted_y_;
+        size_t period_ = 0;
+        size_t pos_ = 0;
+        size_t count_ = 0;
+        T p_ = 0;
+        T p_test_ = 0;
+        int err_ = NO_INIT;
+        int err_test_ = NO_INIT;
+        bool is_test_ = false;
+
+        /* ранг нового значения среди окна без вытесняемого значения */
+        static T calc_new_rank(const std::vector<T> &sorted, const T old_value, const T value) {
+            auto range = std::equal_range(sorted.begin(), sorted.end(), value);
+            T less = (T)std::distance(sorted.begin(), range.first);
+            T equal = (T)std::distance(range.first, range.second);
+            if(old_value < value) less -= 1;
+            else if(old_value == value) equal -= 1;
+            return less + 1 + equal / (T)2;
+        }
+
+        static void replace_sorted(std::vector<T> &sorted, const T old_value, const T value) {
+            auto it = std::lower_bound(sorted.begin(), sorted.end(), old_value);
+            sorted.erase(it);
+            sorted.insert(std::upper_bound(sorted.begin(), sorted.end(), value), value);
+        }
+
+        int calc(const T x, const T y, const bool is_store, T &p) {
+            const T x0 = data_x_[pos_];
+            const T y0 = data_y_[pos_];
+            const T new_rx = calc_new_rank(sorted_x_, x0, x);
+            const T new_ry = calc_new_rank(sorted_y_, y0, y);
+            T sum_xx = new_rx * new_rx;
+            T sum_yy = new_ry * new_ry;
+            T sum_xy = new_rx * new_ry;
+            const T half = (T)0.5;
+            for(size_t i = 0; i < period_; ++i) {
+                if(i == pos_) continue;
+                const T xi = data_x_[i];
+                const T yi = data_y_[i];
+                const T rx = rank_x_[i]
+                    - (T)(x0 < xi) - half * (T)(x0 == xi)
+                    + (T)(x < xi) + half * (T)(x == xi);
+                const T ry = rank_y_[i]
+                    - (T)(y0 < yi) - half * (T)(y0 == yi)
+                    + (T)(y < yi) + half * (T)(y == yi);
+                if(is_store) {
+                    rank_x_[i] = rx;
+                    rank_y_[i] = ry;
+                }
+                sum_xx += rx * rx;
+                sum_yy += ry * ry;
+                sum_xy += rx * ry;
+            }
+            if(is_store) {
+                data_x_[pos_] = x;
+                data_y_[pos_] = y;
+                rank_x_[pos_] = new_rx;
+                rank_y_[pos_] = new_ry;
+                replace_sorted(sorted_x_, x0, x);
+                replace_sorted(sorted_y_, y0, y);
+                pos_ = (pos_ + 1) % period_;
+            }
+            return calc_coefficient(sum_xx, sum_yy, sum_xy, p);
+        }
+
+        int calc_coefficient(const T sum_xx, const T sum_yy, const T sum_xy, T &p) const {
+            const T n = (T)period_;
+            const T sum = n * (n + 1) / (T)2;
+            const T var_x = n * sum_xx - sum * sum;
+            const T var_y = n * sum_yy - sum * sum;
+            if(var_x <= 0 || var_y <= 0) return INVALID_PARAMETER;
+            p = (n * sum_xy - sum * sum) / std::sqrt(var_x * var_y);
+            return OK;
+        }
+
+        void init_ranks() {
+            calculate_fractional_ranking(data_x_, rank_x_);
+            calculate_fractional_ranking(data_y_, rank_y_);
+            sorted_x_ = data_x_;
+            sorted_y_ = data_y_;
+            std::sort(sorted_x_.begin(), sorted_x_.end());
+            std::sort(sorted_y_.begin(), sorted_y_.end());
+        }
+    public:
+        RollingSpearman() {};
+
+        /** \brief Инициализировать скользящую корреляцию Спирмена
+         * \param period период
+         */
+        RollingSpearman(const size_t period) : period_(period) {
+            data_x_.resize(period_);
+            data_y_.resize(period_);
+            rank_x_.resize(period_);
+            rank_y_.resize(period_);
+            sorted_x_.reserve(period_);
+            sorted_y_.reserve(period_);
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \param p коэффициент корреляции Спирмена (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T x, const T y, T &p) {
+            is_test_ = false;
+            p = 0;
+            if(period_ < 2) return NO_INIT;
+            if(count_ < period_) {
+                data_x_[pos_] = x;
+                data_y_[pos_] = y;
+                pos_ = (pos_ + 1) % period_;
+                if(++count_ < period_) {
+                    err_ = INDICATOR_NOT_READY_TO_WORK;
+                    return err_;
+                }
+                init_ranks();
+                T sum_xx = 0, sum_yy = 0, sum_xy = 0;
+                for(size_t i = 0; i < period_; ++i) {
+                    sum_xx += rank_x_[i] * rank_x_[i];
+                    sum_yy += rank_y_[i] * rank_y_[i];
+                    sum_xy += rank_x_[i] * rank_y_[i];
+                }
+                err_ = calc_coefficient(sum_xx, sum_yy, sum_xy, p_);
+            } else {
+                err_ = calc(x, y, true, p_);
+            }
+            if(err_ == OK) p = p_;
+            return err_;
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T x, const T y) {
+            T p = 0;
+            return update(x, y, p);
+        }
+
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем, что не влияет на внутреннее
+         * состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \param p коэффициент корреляции Спирмена (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int test(const T x, const T y, T &p) {
+            is_test_ = true;
+            p = 0;
+            if(period_ < 2) {
+                err_test_ = NO_INIT;
+                return err_test_;
+            }
+            if(count_ < period_) {
+                if(count_ + 1 < period_) {
+                    err_test_ = INDICATOR_NOT_READY_TO_WORK;
+                    return err_test_;
+                }
+                RollingSpearman<T> temp = *this;
+                err_test_ = temp.update(x, y, p_test_);
+            } else {
+                err_test_ = calc(x, y, false, p_test_);
+            }
+            if(err_test_ == OK) p = p_test_;
+            return err_test_;
+        }
+
+        /** \brief Получить коэффициент корреляции
+         *
+         * Вернет результат последнего вызова update или test
+         * \param p коэффициент корреляции Спирмена (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int get_correlation(T &p) const {
+            if(is_test_) {
+                p = p_test_;
+                return err_test_;
+            }
+            p = p_;
+            return err_;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            pos_ = 0;
+            count_ = 0;
+            sorted_x_.clear();
+            sorted_y_.clear();
+            p_ = p_test_ = 0;
+            err_ = err_test_ = NO_INIT;
+            is_test_ = false;
+        }
+    };
+
+    /** \brief Скользящий коэффициент ранговой корреляции Кендалла (tau-b)
+     *
+     * Разность числа согласованных и несогласованных пар обновляется
+     * при вытеснении старого и добавлении нового значения одним проходом
+     * по окну за O(n), число совпадающих значений для поправки на
+     * связанные ранги находится бинарным поиском по упорядоченным массивам.
+     */
+    template<class T>
+    class RollingKendall {
+    private:
+        std::vector<T> data_x_;
+        std::vector<T> data_y_;
+        std::vector<T> sorted_x_;
+        std::vector<T> sorted_y_;
+        size_t period_ = 0;
+        size_t pos_ = 0;
+        size_t count_ = 0;
+        int64_t sum_sign_ = 0;      ///< Согласованные минус несогласованные пары
+        int64_t ties_x_ = 0;        ///< Число пар с одинаковыми x
+        int64_t ties_y_ = 0;        ///< Число пар с одинаковыми y
+        T tau_ = 0;
+        T tau_test_ = 0;
+        int err_ = NO_INIT;
+        int err_test_ = NO_INIT;
+        bool is_test_ = false;
+
+        static inline int sign(const T value) {
+            return (int)(value > 0) - (int)(value < 0);
+        }
+
+        static int64_t count_equal(const std::vector<T> &sorted, const T value) {
+            auto range = std::equal_range(sorted.begin(), sorted.end(), value);
+            return (int64_t)std::distance(range.first, range.second);
+        }
+
+        int calc_coefficient(
+                const int64_t sum_sign,
+                const int64_t ties_x,
+                const int64_t ties_y,
+                T &tau) const {
+            const int64_t n0 = (int64_t)period_ * (int64_t)(period_ - 1) / 2;
+            const T dx = (T)(n0 - ties_x);
+            const T dy = (T)(n0 - ties_y);
+            if(dx <= 0 || dy <= 0) return INVALID_PARAMETER;
+            tau = (T)sum_sign / std::sqrt(dx * dy);
+            return OK;
+        }
+
+        /* сумма знаков пар нового значения с окном без элемента pos_ */
+        int64_t calc_sum_sign(const T x, const T y) const {
+            int64_t sum = 0;
+            for(size_t i = 0; i < period_; ++i) {
+                if(i == pos_) continue;
+                sum += sign(x - data_x_[i]) * sign(y - data_y_[i]);
+            }
+            return sum;
+        }
+
+        int calc(const T x, const T y, const bool is_store, T &tau) {
+            const T x0 = data_x_[pos_];
+            const T y0 = data_y_[pos_];
+            const int64_t sum_sign = sum_sign_ - calc_sum_sign(x0, y0) + calc_sum_sign(x, y);
+            const int64_t ties_x = ties_x_
+                - (count_equal(sorted_x_, x0) - 1)
+                + (count_equal(sorted_x_, x) - (int64_t)(x0 == x));
+            const int64_t ties_y = ties_y_
+                - (count_equal(sorted_y_, y0) - 1)
+                + (count_equal(sorted_y_, y) - (int64_t)(y0 == y));
+            if(is_store) {
+                sum_sign_ = sum_sign;
+                ties_x_ = ties_x;
+                ties_y_ = ties_y;
+                data_x_[pos_] = x;
+                data_y_[pos_] = y;
+                sorted_x_.erase(std::lower_bound(sorted_x_.begin(), sorted_x_.end(), x0));
+                sorted_x_.insert(std::upper_bound(sorted_x_.begin(), sorted_x_.end(), x), x);
+                sorted_y_.erase(std::lower_bound(sorted_y_.begin(), sorted_y_.end(), y0));
+                sorted_y_.insert(std::upper_bound(sorted_y_.begin(), sorted_y_.end(), y), y);
+                pos_ = (pos_ + 1) % period_;
+            }
+            return calc_coefficient(sum_sign, ties_x, ties_y, tau);
+        }
+
+        void init_sums() {
+            sum_sign_ = 0;
+            for(size_t i = 0; i < period_; ++i) {
+                for(size_t j = i + 1; j < period_; ++j) {
+                    sum_sign_ += sign(data_x_[i] - data_x_[j]) * sign(data_y_[i] - data_y_[j]);
+                }
+            }
+            sorted_x_ = data_x_;
+            sorted_y_ = data_y_;
+            std::sort(sorted_x_.begin(), sorted_x_.end());
+            std::sort(sorted_y_.begin(), sorted_y_.end());
+            ties_x_ = ties_y_ = 0;
+            for(size_t i = 0; i < period_;) {
+                size_t j = i + 1;
+                while(j < period_ && sorted_x_[j] == sorted_x_[i]) ++j;
+                ties_x_ += (int64_t)(j - i) * (int64_t)(j - i - 1) / 2;
+                i = j;
+            }
+            for(size_t i = 0; i < period_;) {
+                size_t j = i + 1;
+                while(j < period_ && sorted_y_[j] == sorted_y_[i]) ++j;
+                ties_y_ += (int64_t)(j - i) * (int64_t)(j - i - 1) / 2;
+                i = j;
+            }
+        }
+    public:
+        RollingKendall() {};
+
+        /** \brief Инициализировать скользящую корреляцию Кендалла
+         * \param period период
+         */
+        RollingKendall(const size_t period) : period_(period) {
+            data_x_.resize(period_);
+            data_y_.resize(period_);
+            sorted_x_.reserve(period_);
+            sorted_y_.reserve(period_);
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \param tau коэффициент корреляции Кендалла (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T x, const T y, T &tau) {
+            is_test_ = false;
+            tau = 0;
+            if(period_ < 2) return NO_INIT;
+            if(count_ < period_) {
+                data_x_[pos_] = x;
+                data_y_[pos_] = y;
+                pos_ = (pos_ + 1) % period_;
+                if(++count_ < period_) {
+                    err_ = INDICATOR_NOT_READY_TO_WORK;
+                    return err_;
+                }
+                init_sums();
+                err_ = calc_coefficient(sum_sign_, ties_x_, ties_y_, tau_);
+            } else {
+                err_ = calc(x, y, true, tau_);
+            }
+            if(err_ == OK) tau = tau_;
+            return err_;
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T x, const T y) {
+            T tau = 0;
+            return update(x, y, tau);
         }
 
-        T3 n = x.size();
-        p = 1.0 - ((6.0 *  sum + d1 + d2)/(n * n * n - n));
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем, что не влияет на внутреннее
+         * состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \param tau коэффициент корреляции Кендалла (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int test(const T x, const T y, T &tau) {
+            is_test_ = true;
+            tau = 0;
+            if(period_ < 2) {
+                err_test_ = NO_INIT;
+                return err_test_;
+            }
+            if(count_ < period_) {
+                if(count_ + 1 < period_) {
+                    err_test_ = INDICATOR_NOT_READY_TO_WORK;
+                    return err_test_;
+                }
+                RollingKendall<T> temp = *this;
+                err_test_ = temp.update(x, y, tau_test_);
+            } else {
+                err_test_ = calc(x, y, false, tau_test_);
+            }
+            if(err_test_ == OK) tau = tau_test_;
+            return err_test_;
+        }
+
+        /** \brief Получить коэффициент корреляции
+         *
+         * Вернет результат последнего вызова update или test
+         * \param tau коэффициент корреляции Кендалла (от -1 до +1)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int get_correlation(T &tau) const {
+            if(is_test_) {
+                tau = tau_test_;
+                return err_test_;
+            }
+            tau = tau_;
+            return err_;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            pos_ = 0;
+            count_ = 0;
+            sorted_x_.clear();
+            sorted_y_.clear();
+            sum_sign_ = ties_x_ = ties_y_ = 0;
+            tau_ = tau_test_ = 0;
+            err_ = err_test_ = NO_INIT;
+            is_test_ = false;
+        }
+    };
+
+    /** \brief Взаимная корреляционная функция на основе БПФ
+     *
+     * Считает коэффициенты корреляции для всех сдвигов от -max_lag до max_lag
+     * за O(n log n) вместо O(max_lag * n). Буферы и таблицы БПФ сохраняются
+     * между вызовами.
+     */
+    template<class T>
+    class CrossCorrelation {
+    private:
+        xtechnical_dft::Fft<T> fft_;
+        std::vector<T> real_x_, imag_x_;
+        std::vector<T> real_y_, imag_y_;
+    public:
+        CrossCorrelation() {};
+
+        /** \brief Посчитать взаимную корреляционную функцию
+         * \param x первая выборка данных
+         * \param y вторая выборка данных
+         * \param max_lag максимальный сдвиг (меньше размера выборки)
+         * \param out массив размером 2 * max_lag + 1, элемент max_lag + k
+         * содержит корреляцию x[t] и y[t + k]. Положительный сдвиг
+         * максимума означает, что x опережает y
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template<class T1, class T2>
+        int calc(const T1 &x, const T1 &y, const size_t max_lag, std::vector<T2> &out) {
+            const size_t size = x.size();
+            if(size < 2 || y.size() != size || max_lag >= size) return INVALID_PARAMETER;
+            size_t fft_size = 1;
+            while(fft_size < size + max_lag) fft_size *= 2;
+            real_x_.assign(fft_size, T(0));
+            imag_x_.assign(fft_size, T(0));
+            real_y_.assign(fft_size, T(0));
+            imag_y_.assign(fft_size, T(0));
+
+            T mean_x = 0, mean_y = 0;
+            for(size_t i = 0; i < size; ++i) {
+                mean_x += x[i];
+                mean_y += y[i];
+            }
+            mean_x /= (T)size;
+            mean_y /= (T)size;
+            T sum_xx = 0, sum_yy = 0;
+            for(size_t i = 0; i < size; ++i) {
+                real_x_[i] = x[i] - mean_x;
+                real_y_[i] = y[i] - mean_y;
+                sum_xx += real_x_[i] * real_x_[i];
+                sum_yy += real_y_[i] * real_y_[i];
+            }
+            if(sum_xx == 0 || sum_yy == 0) return INVALID_PARAMETER;
+
+            fft_.calc_fft(real_x_, imag_x_);
+            fft_.calc_fft(real_y_, imag_y_);
+            /* спектр взаимной корреляции conj(X) * Y */
+            for(size_t i = 0; i < fft_size; ++i) {
+                const T re = real_x_[i] * real_y_[i] + imag_x_[i] * imag_y_[i];
+                const T im = real_x_[i] * imag_y_[i] - imag_x_[i] * real_y_[i];
+                real_x_[i] = re;
+                imag_x_[i] = im;
+            }
+            fft_.calc_ifft(real_x_, imag_x_);
+
+            const T norm = 1.0 / std::sqrt(sum_xx * sum_yy);
+            out.resize(2 * max_lag + 1);
+            out[max_lag] = real_x_[0] * norm;
+            for(size_t k = 1; k <= max_lag; ++k) {
+                out[max_lag + k] = real_x_[k] * norm;
+                out[max_lag - k] = real_x_[fft_size - k] * norm;
+            }
+            return OK;
+        }
+    };
+
+    /** \brief Посчитать взаимную корреляционную функцию
+     * \param x первая выборка данных
+     * \param y вторая выборка данных
+     * \param max_lag максимальный сдвиг (меньше размера выборки)
+     * \param out массив размером 2 * max_lag + 1, элемент max_lag + k
+     * содержит корреляцию x[t] и y[t + k]
+     * \return вернет 0 в случае успеха, иначе см. ErrorType
+     */
+    template<class T1, class T2>
+    int calculate_cross_correlation(
+            const std::vector<T1> &x,
+            const std::vector<T1> &y,
+            const size_t max_lag,
+            std::vector<T2> &out) {
+        CrossCorrelation<T2> iCrossCorrelation;
+        return iCrossCorrelation.calc(x, y, max_lag, out);
+    }
+
+    /** \brief Найти сдвиг с максимальной по модулю корреляцией
+     * \param ccf взаимная корреляционная функция (см. calculate_cross_correlation)
+     * \param lag сдвиг (положительный, если первая выборка опережает вторую)
+     * \param coefficient коэффициент корреляции для найденного сдвига
+     * \return вернет 0 в случае успеха, иначе см. ErrorType
+     */
+    template<class T1>
+    int find_cross_correlation_lag(
+            const std::vector<T1> &ccf,
+            int &lag,
+            T1 &coefficient) {
+        if(ccf.size() == 0 || ccf.size() % 2 == 0) return INVALID_PARAMETER;
+        const int max_lag = (int)ccf.size() / 2;
+        size_t index = 0;
+        for(size_t i = 1; i < ccf.size(); ++i) {
+            if(std::abs(ccf[i]) > std::abs(ccf[index])) index = i;
+        }
+        lag = (int)index - max_lag;
+        coefficient = ccf[index];
         return OK;
     }
 
+    /** \brief Скользящая взаимная корреляционная функция
+     *
+     * Хранит парный кольцевой буфер и пересчитывает функцию
+     * через БПФ раз в refresh_period обновлений
+     */
+    template<class T>
+    class RollingCrossCorrelation {
+    private:
+        std::vector<T> data_x_;
+        std::vector<T> data_y_;
+        std::vector<T> window_x_;
+        std::vector<T> window_y_;
+        std::vector<T> ccf_;
+        CrossCorrelation<T> iCrossCorrelation;
+        size_t period_ = 0;
+        size_t max_lag_ = 0;
+        size_t refresh_period_ = 1;
+        size_t pos_ = 0;
+        size_t count_ = 0;
+        size_t num_updates_ = 0;
+        int err_ = NO_INIT;
+    public:
+        RollingCrossCorrelation() {};
+
+        /** \brief Инициализировать скользящую взаимную корреляцию
+         * \param period период
+         * \param max_lag максимальный сдвиг (меньше периода)
+         * \param refresh_period период пересчета функции (K баров)
+         */
+        RollingCrossCorrelation(
+                const size_t period,
+                const size_t max_lag,
+                const size_t refresh_period = 1) :
+                period_(period),
+                max_lag_(max_lag),
+                refresh_period_(refresh_period == 0 ? 1 : refresh_period) {
+            data_x_.resize(period_);
+            data_y_.resize(period_);
+            window_x_.resize(period_);
+            window_y_.resize(period_);
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param x значение первой выборки
+         * \param y значение второй выборки
+         * \return вернет 0, если функция доступна, иначе см. ErrorType
+         */
+        int update(const T x, const T y) {
+            if(period_ < 2 || max_lag_ >= period_) return NO_INIT;
+            data_x_[pos_] = x;
+            data_y_[pos_] = y;
+            pos_ = (pos_ + 1) % period_;
+            if(count_ < period_) {
+                if(++count_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+                num_updates_ = refresh_period_;
+            } else {
+                ++num_updates_;
+            }
+            if(num_updates_ >= refresh_period_) {
+                for(size_t i = 0; i < period_; ++i) {
+                    window_x_[i] = data_x_[(pos_ + i) % period_];
+                    window_y_[i] = data_y_[(pos_ + i) % period_];
+                }
+                err_ = iCrossCorrelation.calc(window_x_, window_y_, max_lag_, ccf_);
+                num_updates_ = 0;
+            }
+            return err_;
+        }
+
+        /** \brief Получить последнюю рассчитанную взаимную корреляционную функцию
+         * \param out массив размером 2 * max_lag + 1
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int get_cross_correlation(std::vector<T> &out) const {
+            if(err_ != OK) return err_;
+            out = ccf_;
+            return OK;
+        }
+
+        /** \brief Найти сдвиг с максимальной по модулю корреляцией
+         * \param lag сдвиг (положительный, если первая выборка опережает вторую)
+         * \param coefficient коэффициент корреляции
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int get_lag(int &lag, T &coefficient) const {
+            if(err_ != OK) return err_;
+            return find_cross_correlation_lag(ccf_, lag, coefficient);
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            pos_ = 0;
+            count_ = 0;
+            num_updates_ = 0;
+            ccf_.clear();
+            err_ = NO_INIT;
+        }
+    };
+
     /** \brief Найти число степеней свободы
      * \param размер 1 выборки
      * \param размер 2 выборки
@@ -216,7 +1584,184 @@ namespace xtechnical_correlation {
         return p * std::sqrt(size - 2) / std::sqrt(1.0 - p * p);
     }
 
-//      Критические точки распределения Стьюдента
+    /** \brief Посчитать регуляризованную неполную бета-функцию I_x(a, b)
+     *
+     * Используется цепная дробь (метод Лентца)
+     * \param a параметр a > 0
+     * \param b параметр b > 0
+     * \param x аргумент от 0 до 1
+     * \return значение I_x(a, b)
+     */
+    inline double calculate_regularized_incomplete_beta(const double a, const double b, const double x) {
+        if(x <= 0.0) return 0.0;
+        if(x >= 1.0) return 1.0;
+        const bool is_swap = x >= (a + 1.0) / (a + b + 2.0);
+        const double aa = is_swap ? b : a;
+        const double bb = is_swap ? a : b;
+        const double xx = is_swap ? 1.0 - x : x;
+        const double front = std::exp(
+            std::lgamma(aa + bb) - std::lgamma(aa) - std::lgamma(bb) +
+            aa * std::log(xx) + bb * std::log1p(-xx)) / aa;
+
+        const int MAX_ITERATIONS = 300;
+        const double EPS = 1.0e-15;
+        const double FPMIN = 1.0e-300;
+        double c = 1.0;
+        double d = 1.0 - (aa + bb) * xx / (aa + 1.0);
+        if(std::abs(d) < FPMIN) d = FPMIN;
+        d = 1.0 / d;
+        double h = d;
+        for(int m = 1; m <= MAX_ITERATIONS; ++m) {
+            const double m2 = 2.0 * m;
+            double num = m * (bb - m) * xx / ((aa - 1.0 + m2) * (aa + m2));
+            d = 1.0 + num * d;
+            if(std::abs(d) < FPMIN) d = FPMIN;
+            c = 1.0 + num / c;
+            if(std::abs(c) < FPMIN) c = FPMIN;
+            d = 1.0 / d;
+            h *= d * c;
+            num = -(aa + m) * (aa + bb + m) * xx / ((aa + m2) * (aa + 1.0 + m2));
+            d = 1.0 + num * d;
+            if(std::abs(d) < FPMIN) d = FPMIN;
+            c = 1.0 + num / c;
+            if(std::abs(c) < FPMIN) c = FPMIN;
+            d = 1.0 / d;
+            const double delta = d * c;
+            h *= delta;
+            if(std::abs(delta - 1.0) < EPS) break;
+        }
+        return is_swap ? 1.0 - front * h : front * h;
+    }
+
+    /** \brief Посчитать хвост распределения Стьюдента
+     * \param t значение t-статистики, t >= 0
+     * \param degrees_freedom число степеней свободы (может быть дробным)
+     * \return вероятность P(T > t)
+     */
+    inline double calculate_student_t_tail(const double t, const double degrees_freedom) {
+        return 0.5 * calculate_regularized_incomplete_beta(
+            0.5 * degrees_freedom, 0.5, degrees_freedom / (degrees_freedom + t * t));
+    }
+
+    /** \brief Посчитать функцию распределения Стьюдента
+     * \param t значение t-статистики
+     * \param degrees_freedom число степеней свободы (может быть дробным)
+     * \return вероятность P(T <= t)
+     */
+    inline double calculate_student_t_cdf(const double t, const double degrees_freedom) {
+        if(degrees_freedom <= 0) return 0.0;
+        const double tail = calculate_student_t_tail(std::abs(t), degrees_freedom);
+        return t > 0 ? 1.0 - tail : tail;
+    }
+
+    /** \brief Посчитать квантиль стандартного нормального распределения
+     *
+     * Рациональная аппроксимация Акклама, относительная ошибка меньше 1.2e-9
+     * \param probability вероятность от 0 до 1
+     * \return значение z, для которого P(Z <= z) = probability
+     */
+    inline double calculate_normal_quantile(const double probability) {
+        if(!(probability > 0.0 && probability < 1.0)) return 0.0;
+        const double a[] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+            1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+        const double b[] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+            6.680131188771972e+01, -1.328068155288572e+01};
+        const double c[] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+            -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+        const double d[] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+            3.754408661907416e+00};
+        const double P_LOW = 0.02425;
+        if(probability < P_LOW || probability > 1.0 - P_LOW) {
+            const double q = std::sqrt(-2.0 * std::log(std::min(probability, 1.0 - probability)));
+            const double z = (((((c[0] * q + c[1]) * q + c[2]) * q + c[3]) * q + c[4]) * q + c[5]) /
+                ((((d[0] * q + d[1]) * q + d[2]) * q + d[3]) * q + 1.0);
+            return probability < P_LOW ? z : -z;
+        }
+        const double q = probability - 0.5;
+        const double r = q * q;
+        return (((((a[0] * r + a[1]) * r + a[2]) * r + a[3]) * r + a[4]) * r + a[5]) * q /
+            (((((b[0] * r + b[1]) * r + b[2]) * r + b[3]) * r + b[4]) * r + 1.0);
+    }
+
+    /** \brief Посчитать значение t по хвосту распределения Стьюдента
+     *
+     * Начальное приближение дает разложение Корниша-Фишера (для 1 и 2 степеней
+     * свободы - точные формулы), затем уравнение для хвоста распределения
+     * решается методом Ньютона в логарифмическом масштабе с защитой бисекцией.
+     * Точность порядка 1e-12
+     * \param tail вероятность хвоста от 0 до 0.5
+     * \param degrees_freedom число степеней свободы (может быть дробным)
+     * \return значение t >= 0, для которого P(T > t) = tail
+     */
+    inline double calculate_student_t_tail_quantile(const double tail, const double degrees_freedom) {
+        if(degrees_freedom <= 0 || !(tail > 0.0 && tail < 0.5)) return 0.0;
+        const double pi = 3.14159265358979323846;
+        const double v = degrees_freedom;
+        if(v == 1.0) return 1.0 / std::tan(pi * tail);
+        if(v == 2.0) return (1.0 - 2.0 * tail) / std::sqrt(2.0 * tail * (1.0 - tail));
+
+        const double z = -calculate_normal_quantile(tail);
+        const double z2 = z * z;
+        const double g1 = (z2 + 1.0) * z / 4.0;
+        const double g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+        const double g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+        const double g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z / 92160.0;
+        const double t0 = z + (g1 + (g2 + (g3 + g4 / v) / v) / v) / v;
+
+        /* ln(хвост) убывает по u = ln(t), корень на отрезке [u_lo, u_hi] */
+        const double target = std::log(tail);
+        const double log_pdf_norm = std::lgamma(0.5 * (v + 1.0)) - std::lgamma(0.5 * v) - 0.5 * std::log(v * pi);
+        double u_lo = std::log(1.0e-12);
+        double u_hi = 710.0;
+        double u = t0 > 0 ? std::log(t0) : 0.0;
+        const int MAX_ITERATIONS = 100;
+        for(int i = 0; i < MAX_ITERATIONS; ++i) {
+            const double t = std::exp(u);
+            const double tail_u = calculate_student_t_tail(t, v);
+            const double g = std::log(tail_u) - target;
+            if(g > 0) u_lo = u;
+            else u_hi = u;
+            const double log_pdf = log_pdf_norm - 0.5 * (v + 1.0) * std::log1p(t * t / v);
+            const double dg = -t * std::exp(log_pdf) / tail_u;
+            double u_next = u - g / dg;
+            if(!(u_next > u_lo && u_next < u_hi)) u_next = 0.5 * (u_lo + u_hi);
+            if(std::abs(u_next - u) < 1.0e-13) return std::exp(u_next);
+            u = u_next;
+        }
+        return std::exp(u);
+    }
+
+    /** \brief Посчитать квантиль распределения Стьюдента
+     * \param probability вероятность от 0 до 1
+     * \param degrees_freedom число степеней свободы (может быть дробным)
+     * \return значение t, для которого P(T <= t) = probability
+     */
+    inline double calculate_student_t_quantile(const double probability, const double degrees_freedom) {
+        if(degrees_freedom <= 0 || !(probability > 0.0 && probability < 1.0)) return 0.0;
+        if(probability > 0.5) return calculate_student_t_tail_quantile(1.0 - probability, degrees_freedom);
+        return -calculate_student_t_tail_quantile(probability, degrees_freedom);
+    }
+
+    /** \brief Посчитать критическую точку распределения Стьюдента
+     * \param significance_level уровень значимости α, например 0.05
+     * \param degrees_freedom число степеней свободы (может быть дробным)
+     * \param is_two_sided двусторонняя критическая область
+     * \return критическое значение t-критерия
+     */
+    inline double calculate_critical_t_point(
+            const double significance_level,
+            const double degrees_freedom,
+            const bool is_two_sided = true) {
+        const double alpha = is_two_sided ? 0.5 * significance_level : significance_level;
+        return calculate_student_t_tail_quantile(alpha, degrees_freedom);
+    }
+
+    /** \brief Критические точки распределения Стьюдента (справочная таблица)
+     *
+     * \deprecated Библиотека таблицу больше не использует, она оставлена для совместимости.
+     * Строки - число степеней свободы (см. комментарии в конце строк), столбцы - уровни
+     * значимости SignificanceLevel. Используйте get_critical_t_points или calculate_critical_t_point
+     */
     const double table_critical_t_points[] = {
 //      Уровень значимости α (двусторонняя критическая область)
 //      0.10            0.05            0.02            0.01            0.002           0.001
@@ -320,90 +1865,95 @@ namespace xtechnical_correlation {
         ONE_SIDED_CRITICAl_AREA_0P0005 = 5,     ///< Уровень значимости 0.0005 (односторонняя критическая область)
     };
 
+    enum {
+        CRITICAL_T_POINTS_NUM_LEVELS = 6,       ///< Количество уровней значимости SignificanceLevel
+        CRITICAL_T_POINTS_TABLE_SIZE = 1000,    ///< Максимальное число степеней свободы в таблице get_critical_t_points
+    };
+
+    /// Уровни значимости (двусторонняя критическая область) для SignificanceLevel
+    const double critical_t_points_significance_levels[] = {
+        0.1, 0.05, 0.02, 0.01, 0.002, 0.001
+    };
+
+    /** \brief Коэффициенты разложения критической точки распределения Стьюдента по 1/df
+     *
+     * t = z + g1/df + g2/df^2 + g3/df^3 + g4/df^4 (разложение Корниша-Фишера),
+     * где z - критическая точка нормального распределения (предел при df -> бесконечность)
+     */
+    struct CriticalTPointExpansion {
+        double z = 0;
+        double g1 = 0;
+        double g2 = 0;
+        double g3 = 0;
+        double g4 = 0;
+    };
+
+    /** \brief Получить коэффициенты разложения для всех уровней SignificanceLevel
+     *
+     * Коэффициенты считаются один раз при первом обращении. Для числа степеней
+     * свободы больше CRITICAL_T_POINTS_TABLE_SIZE отброшенные члены разложения
+     * меньше 1e-12, поэтому разложение заменяет обращение хвоста распределения
+     * \return массив из CRITICAL_T_POINTS_NUM_LEVELS коэффициентов
+     */
+    inline const CriticalTPointExpansion *get_critical_t_point_expansions() {
+        struct Builder {
+            static std::vector<CriticalTPointExpansion> build() {
+                std::vector<CriticalTPointExpansion> expansions(CRITICAL_T_POINTS_NUM_LEVELS);
+                for(int l = 0; l < CRITICAL_T_POINTS_NUM_LEVELS; ++l) {
+                    const double tail = 0.5 * critical_t_points_significance_levels[l];
+                    /* аппроксимацию Акклама уточняем шагами Ньютона по хвосту нормального распределения */
+                    double z = -calculate_normal_quantile(tail);
+                    for(int i = 0; i < 3; ++i) {
+                        const double tail_z = 0.5 * std::erfc(z / std::sqrt(2.0));
+                        const double pdf_z = std::exp(-0.5 * z * z) / std::sqrt(2.0 * 3.14159265358979323846);
+                        z += (tail_z - tail) / pdf_z;
+                    }
+                    const double z2 = z * z;
+                    CriticalTPointExpansion &e = expansions[l];
+                    e.z = z;
+                    e.g1 = (z2 + 1.0) * z / 4.0;
+                    e.g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+                    e.g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+                    e.g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z / 92160.0;
+                }
+                return expansions;
+            }
+        };
+        static const std::vector<CriticalTPointExpansion> expansions = Builder::build();
+        return expansions.data();
+    }
+
     /** \brief Получить t-критерий Стьюдента в зависимости от уровня значимости и числа степеней свободы
+     *
+     * Для числа степеней свободы до CRITICAL_T_POINTS_TABLE_SIZE значение считается
+     * через calculate_critical_t_point при первом обращении и запоминается в таблице,
+     * для большего считается по разложению get_critical_t_point_expansions за несколько умножений
      * \param significance_level уровень значимости (см. SignificanceLevel, для 0.05 выбрать BI_CRITICAl_AREA_0P05)
      * \param degrees_freedom число степеней свободы
-     * \return табличное значение для t-критерия
+     * \return значение для t-критерия
      */
-    double get_critical_t_points(
+    inline double get_critical_t_points(
             const int significance_level,
             const int degrees_freedom) {
-        const int PART_FACTOR = 6;
-        const int PART_1_SIZE = 30;
-        const int PART_2_SIZE = 200;
-        const int PART_2_STEP = 10;
-        const int PART_3_SIZE = 300;
-        const int PART_3_STEP = 20;
-        const int PART_4_SIZE = 1000;
-        const int PART_4_STEP = 100;
-        const int PART_5_SIZE = 10000;
-        const int PART_5_STEP = 1000;
-        const int PART_6_SIZE = 100000;
-        const int PART_6_STEP = 10000;
-
-        if(degrees_freedom >= 1 && degrees_freedom <= PART_1_SIZE) {
-            return table_critical_t_points[(degrees_freedom - 1) * PART_FACTOR + significance_level];
-        } else
-        if(degrees_freedom > PART_1_SIZE && degrees_freedom <= PART_2_SIZE) {
-            const int TABLE_OFFSET = PART_FACTOR * (PART_1_SIZE - 1);
-            return table_critical_t_points[
-                TABLE_OFFSET +
-                (((degrees_freedom - PART_1_SIZE - 1)/PART_2_STEP)) * PART_FACTOR +
-                significance_level];
-        } else
-        if(degrees_freedom > PART_2_SIZE && degrees_freedom <= PART_3_SIZE) {
-            const int TABLE_OFFSET =
-                PART_FACTOR * (PART_1_SIZE - 1) +
-                PART_FACTOR * (PART_2_SIZE - PART_1_SIZE) / PART_2_STEP;
-            return table_critical_t_points[
-                TABLE_OFFSET +
-                (((degrees_freedom - PART_2_SIZE - 1)/PART_3_STEP)) * PART_FACTOR +
-                significance_level];
-        } else
-        if(degrees_freedom > PART_3_SIZE && degrees_freedom <= PART_4_SIZE) {
-            const int TABLE_OFFSET =
-                PART_FACTOR * (PART_1_SIZE - 1) +
-                PART_FACTOR * (PART_2_SIZE - PART_1_SIZE) / PART_2_STEP +
-                PART_FACTOR * (PART_3_SIZE - PART_2_SIZE) / PART_3_STEP;
-            return table_critical_t_points[
-                TABLE_OFFSET +
-                ((degrees_freedom - PART_3_SIZE - 1)/PART_4_STEP) * PART_FACTOR +
-                significance_level];
-        } else
-        if(degrees_freedom > PART_4_SIZE && degrees_freedom <= PART_5_SIZE) {
-            const int TABLE_OFFSET =
-                PART_FACTOR * (PART_1_SIZE - 1) +
-                PART_FACTOR * (PART_2_SIZE - PART_1_SIZE) / PART_2_STEP +
-                PART_FACTOR * (PART_3_SIZE - PART_2_SIZE) / PART_3_STEP +
-                PART_FACTOR * (PART_4_SIZE - PART_3_SIZE) / PART_4_STEP;
-            return table_critical_t_points[
-                TABLE_OFFSET +
-                ((degrees_freedom - PART_4_SIZE - 1)/PART_5_STEP) * PART_FACTOR +
-                significance_level];
-        } else
-        if(degrees_freedom > PART_5_SIZE && degrees_freedom <= PART_6_SIZE) {
-            const int TABLE_OFFSET =
-                PART_FACTOR * (PART_1_SIZE - 1) +
-                PART_FACTOR * (PART_2_SIZE - PART_1_SIZE) / PART_2_STEP +
-                PART_FACTOR * (PART_3_SIZE - PART_2_SIZE) / PART_3_STEP +
-                PART_FACTOR * (PART_4_SIZE - PART_3_SIZE) / PART_4_STEP +
-                PART_FACTOR * (PART_5_SIZE - PART_4_SIZE) / PART_5_STEP;
-            return table_critical_t_points[
-                TABLE_OFFSET +
-                ((degrees_freedom - PART_5_SIZE - 1)/PART_6_STEP) * PART_FACTOR +
-                significance_level];
-        } else
-        if(degrees_freedom > PART_6_SIZE) {
-            const int TABLE_OFFSET =
-                PART_FACTOR * (PART_1_SIZE - 1) +
-                PART_FACTOR * (PART_2_SIZE - PART_1_SIZE) / PART_2_STEP +
-                PART_FACTOR * (PART_3_SIZE - PART_2_SIZE) / PART_3_STEP +
-                PART_FACTOR * (PART_4_SIZE - PART_3_SIZE) / PART_4_STEP +
-                PART_FACTOR * (PART_5_SIZE - PART_4_SIZE) / PART_5_STEP +
-                PART_FACTOR * (PART_6_SIZE - PART_5_SIZE) / PART_6_STEP;
-            return table_critical_t_points[TABLE_OFFSET +significance_level];
-        }
-        return 0.0;
+        if(degrees_freedom < 1 ||
+            significance_level < 0 ||
+            significance_level >= CRITICAL_T_POINTS_NUM_LEVELS) return 0.0;
+        if(degrees_freedom <= CRITICAL_T_POINTS_TABLE_SIZE) {
+            /* статический массив обнулен до запуска программы, 0 - значение еще не посчитано */
+            static std::atomic<double> table[CRITICAL_T_POINTS_TABLE_SIZE * CRITICAL_T_POINTS_NUM_LEVELS];
+            std::atomic<double> &cell = table[(degrees_freedom - 1) * CRITICAL_T_POINTS_NUM_LEVELS + significance_level];
+            double value = cell.load(std::memory_order_relaxed);
+            if(value == 0) {
+                value = calculate_critical_t_point(
+                    critical_t_points_significance_levels[significance_level],
+                    degrees_freedom);
+                cell.store(value, std::memory_order_relaxed);
+            }
+            return value;
+        }
+        const CriticalTPointExpansion &e = get_critical_t_point_expansions()[significance_level];
+        const double v = degrees_freedom;
+        return e.z + (e.g1 + (e.g2 + (e.g3 + e.g4 / v) / v) / v) / v;
     }
 
     /** \brief Оценка коэффициента ранговой корреляции Спирмена.
@@ -426,6 +1976,52 @@ namespace xtechnical_correlation {
         return false;
     }
 
+    /** \brief Посчитать критическое значение коэффициента корреляции по t-критерию Стьюдента
+     *
+     * Условие check_correlation_coefficient_t_criterion равносильно |p| > t / sqrt(df + t^2)
+     * \param significance_level уровень значимости (см. SignificanceLevel, для 0.05 выбрать BI_CRITICAl_AREA_0P05)
+     * \param size объем выборки
+     * \return критическое значение коэффициента корреляции или 0, если параметры неверны
+     */
+    inline double calculate_critical_correlation_coefficient(
+            const int significance_level,
+            const int size) {
+        const int degrees_freedom = size - 2;
+        const double t_criterion = get_critical_t_points(significance_level, degrees_freedom);
+        if(t_criterion <= 0) return 0.0;
+        return t_criterion / std::sqrt((double)degrees_freedom + t_criterion * t_criterion);
+    }
+
+    /** \brief Проверить значимость всех коэффициентов матрицы корреляции по t-критерию Стьюдента
+     *
+     * Все коэффициенты посчитаны по выборкам одного объема, поэтому критическое значение
+     * коэффициента считается один раз, а проверка сводится к сравнению без ветвлений.
+     * Проверка поэлементная, подходит и для упакованной матрицы (см. calculate_correlation_matrix),
+     * и для полной матрицы (см. CorrelationMatrix::get_matrix)
+     * \param matrix коэффициенты корреляции
+     * \param is_significant результат проверки, 1 если коэффициент статистически значим, иначе 0
+     * \param significance_level уровень значимости (см. SignificanceLevel, для 0.05 выбрать BI_CRITICAl_AREA_0P05)
+     * \param size объем выборки
+     * \return вернет 0 в случае успеха, иначе см. ErrorType
+     */
+    template<class T1, class T2>
+    int check_correlation_matrix_t_criterion(
+            const std::vector<T1> &matrix,
+            std::vector<T2> &is_significant,
+            const int significance_level,
+            const int size) {
+        is_significant.resize(matrix.size());
+        const T1 critical_coefficient = calculate_critical_correlation_coefficient(significance_level, size);
+        if(critical_coefficient <= 0) {
+            std::fill(is_significant.begin(), is_significant.end(), T2(0));
+            return INVALID_PARAMETER;
+        }
+        for(size_t i = 0; i < matrix.size(); ++i) {
+            is_significant[i] = (T2)(std::abs(matrix[i]) > critical_coefficient);
+        }
+        return OK;
+    }
+
 }
 
 #endif // CORRELATIONEASY_HPP_INCLUDED
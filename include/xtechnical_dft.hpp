@@ -259,5 +259,128 @@ namespace xtechnical_dft {
             return xtechnical_common::OK;
         }
     };
+
+    /** \brief БПФ для комплексных образцов (radix-2)
+     *
+     * Размер данных должен быть степенью двойки.
+     * Таблицы поворачивающих множителей генерируются один раз на размер.
+     */
+    template<class T>
+    class Fft {
+    private:
+        std::vector<T> sine_table;
+        std::vector<T> cosine_table;
+        std::vector<size_t> bit_reverse_table;
+        size_t table_period = 0;
+
+        void generate_table(const size_t period) {
+            if(period == table_period) return;
+            const size_t period_div2 = period / 2;
+            cosine_table.resize(period_div2);
+            sine_table.resize(period_div2);
+            const T MATH_PI = 3.14159265358979323846264338327950288;
+            const T MATH_PI_X2 = 2.0 * MATH_PI;
+            for(size_t j = 0; j < period_div2; j++) {
+                T temp = MATH_PI_X2 * (T)j / (T)period;
+                cosine_table[j] = std::cos(temp);
+                sine_table[j] = -std::sin(temp);
+            }
+            bit_reverse_table.resize(period);
+            size_t levels = 0;
+            while(((size_t)1 << levels) < period) ++levels;
+            for(size_t i = 0; i < period; ++i) {
+                size_t r = 0;
+                for(size_t b = 0; b < levels; ++b) {
+                    r = (r << 1) | ((i >> b) & 1);
+                }
+                bit_reverse_table[i] = r;
+            }
+            table_period = period;
+        }
+
+        template<class FLOAT_TYPE>
+        void transform(
+                std::vector<FLOAT_TYPE> &real,
+                std::vector<FLOAT_TYPE> &imag,
+                const bool is_inverse) {
+            const size_t period = real.size();
+            generate_table(period);
+            for(size_t i = 0; i < period; ++i) {
+                const size_t j = bit_reverse_table[i];
+                if(j > i) {
+                    std::swap(real[i], real[j]);
+                    std::swap(imag[i], imag[j]);
+                }
+            }
+            const T sign = is_inverse ? -1.0 : 1.0;
+            for(size_t size = 2; size <= period; size *= 2) {
+                const size_t half_size = size / 2;
+                const size_t table_step = period / size;
+                for(size_t i = 0; i < period; i += size) {
+                    for(size_t j = 0; j < half_size; ++j) {
+                        const size_t k = j * table_step;
+                        const FLOAT_TYPE wr = cosine_table[k];
+                        const FLOAT_TYPE wi = sign * sine_table[k];
+                        const size_t l = i + j + half_size;
+                        const FLOAT_TYPE tr = real[l] * wr - imag[l] * wi;
+                        const FLOAT_TYPE ti = real[l] * wi + imag[l] * wr;
+                        real[l] = real[i + j] - tr;
+                        imag[l] = imag[i + j] - ti;
+                        real[i + j] += tr;
+                        imag[i + j] += ti;
+                    }
+                }
+            }
+        }
+    public:
+        Fft() {};
+
+        Fft(const size_t period) {
+            generate_table(period);
+        }
+
+        /** \brief Проверить, что размер является степенью двойки
+         * \param period размер
+         * \return вернет true, если размер является степенью двойки
+         */
+        static bool is_power_of_two(const size_t period) {
+            return period != 0 && (period & (period - 1)) == 0;
+        }
+
+        /** \brief Прямое БПФ (без нормировки), выполняется на месте
+         * \param real действительная часть
+         * \param imag мнимая часть
+         * \return вернет 0 в случае успеха
+         */
+        template<class FLOAT_TYPE>
+        int calc_fft(
+                std::vector<FLOAT_TYPE> &real,
+                std::vector<FLOAT_TYPE> &imag) {
+            if(!is_power_of_two(real.size()) || imag.size() != real.size())
+                return xtechnical_common::INVALID_PARAMETER;
+            transform(real, imag, false);
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Обратное БПФ (с нормировкой на размер), выполняется на месте
+         * \param real действительная часть
+         * \param imag мнимая часть
+         * \return вернет 0 в случае успеха
+         */
+        template<class FLOAT_TYPE>
+        int calc_ifft(
+                std::vector<FLOAT_TYPE> &real,
+                std::vector<FLOAT_TYPE> &imag) {
+            if(!is_power_of_two(real.size()) || imag.size() != real.size())
+                return xtechnical_common::INVALID_PARAMETER;
+            transform(real, imag, true);
+            const FLOAT_TYPE norm = 1.0 / (FLOAT_TYPE)real.size();
+            for(size_t i = 0; i < real.size(); ++i) {
+                real[i] *= norm;
+                imag[i] *= norm;
+            }
+            return xtechnical_common::OK;
+        }
+    };
 }
 #endif // XTECHNICAL_DFT_HPP_INCLUDED
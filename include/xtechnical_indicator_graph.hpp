@@ -0,0 +1,527 @@
+/*
+* xtechnical_analysis - Technical analysis C++ library
+*
+* Copyright (c) 2018 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef XTECHNICAL_INDICATOR_GRAPH_HPP_INCLUDED
+#define XTECHNICAL_INDICATOR_GRAPH_HPP_INCLUDED
+
+#include "xtechnical_common.hpp"
+#include <vector>
+#include <string>
+#include <map>
+#include <sstream>
+#include <cmath>
+#include <cctype>
+#include <cstdlib>
+
+namespace xtechnical_indicators {
+    using namespace xtechnical_common;
+
+    /** \brief Граф индикаторов
+     *
+     * Индикаторы задаются выражениями, например "SMA(close,20)",
+     * "RSI(close,14)" или "BB_UPPER(close,20,2)". Одинаковые узлы (в том числе
+     * общие части составных индикаторов: RSI строится из SMA(GAIN(x),n) и
+     * SMA(LOSS(x),n), линии Боллинджера из SMA(x,n) и STDDEV(x,n)) создаются
+     * один раз. Для каждого ряда, который нужен оконным индикаторам, хранится
+     * одно общее окно длиной по самому длинному периоду. Узлы вычисляются
+     * по порядку создания, который всегда топологический.
+     *
+     * Поддерживаемые узлы:
+     * - имя входа (добавляется через add_input)
+     * - SMA(x,n), EMA(x,n), MMA(x,n), WMA(x,n) - как классы SMA, EMA, MMA, WMA
+     * - STDDEV(x,n) - выборочное стандартное отклонение за n значений
+     * - BB_UPPER(x,n,k), BB_LOWER(x,n,k) - линии Боллинджера, средняя линия - SMA(x,n)
+     * - GAIN(x), LOSS(x) - рост и падение ряда
+     * - RSI(x,n) - как RSI<T,SMA<T>>
+     * - ADD(x,y), SUB(x,y) - сумма и разность рядов
+     */
+    template <class T>
+    class IndicatorGraph {
+    public:
+
+        /// Типы узлов графа
+        enum {
+            NODE_INPUT = 0,
+            NODE_SMA = 1,
+            NODE_EMA = 2,
+            NODE_MMA = 3,
+            NODE_WMA = 4,
+            NODE_STDDEV = 5,
+            NODE_BB_UPPER = 6,
+            NODE_BB_LOWER = 7,
+            NODE_GAIN = 8,
+            NODE_LOSS = 9,
+            NODE_RSI = 10,
+            NODE_ADD = 11,
+            NODE_SUB = 12,
+        };
+
+    private:
+        static const size_t NONE = (size_t)-1;
+
+        /// Общее окно значений ряда
+        class Window {
+        public:
+            std::vector<T> data;
+            size_t pos = 0;
+            size_t count = 0;
+
+            inline void push(const T value) {
+                pos = pos + 1 < data.size() ? pos + 1 : 0;
+                data[pos] = value;
+                if(count < data.size()) ++count;
+            }
+
+            /** \brief Получить значение окна
+             * \param lag 0 - последнее значение, 1 - предыдущее и т.д.
+             */
+            inline T get(const size_t lag) const {
+                return data[pos >= lag ? pos - lag : pos + data.size() - lag];
+            }
+        };
+
+        /// Узел графа
+        class Node {
+        public:
+            int type = NODE_INPUT;
+            std::string key;
+            size_t input[2] = {NONE, NONE};
+            size_t period = 0;
+            T factor = 0;
+            size_t window = NONE;   /**< окно значений этого узла, если оно нужно */
+            /* состояние */
+            T value = 0;
+            T sum = 0;
+            T prev = 0;
+            size_t count = 0;
+            bool is_ready = false;
+        };
+
+        std::vector<Node> nodes_;
+        std::vector<Window> windows_;
+        std::vector<size_t> inputs_;
+        std::map<std::string, size_t> keys_;
+
+        static std::string to_string(const T value) {
+            std::ostringstream stream;
+            stream.precision(17);
+            stream << value;
+            return stream.str();
+        }
+
+        /** \brief Получить ключ узла
+         * \param name имя индикатора
+         * \param input узел входного ряда
+         * \param args остальные аргументы через запятую
+         */
+        std::string make_key(const std::string &name, const size_t input, const std::string &args = std::string()) const {
+            return name + "(" + nodes_[input].key + args + ")";
+        }
+
+        /** \brief Добавить узел, если такого еще нет
+         * \param key ключ узла в каноническом виде
+         * \return номер узла
+         */
+        size_t add_unique(
+                const std::string &key,
+                const int type,
+                const size_t input_1,
+                const size_t input_2 = NONE,
+                const size_t period = 0,
+                const T factor = 0) {
+            typename std::map<std::string, size_t>::const_iterator it = keys_.find(key);
+            if(it != keys_.end()) return it->second;
+            Node node;
+            node.type = type;
+            node.key = key;
+            node.input[0] = input_1;
+            node.input[1] = input_2;
+            node.period = period;
+            node.factor = factor;
+            nodes_.push_back(node);
+            const size_t id = nodes_.size() - 1;
+            keys_[key] = id;
+            if(type == NODE_SMA || type == NODE_WMA || type == NODE_STDDEV) {
+                add_window(input_1, period + 1);
+            }
+            return id;
+        }
+
+        void add_window(const size_t source, const size_t length) {
+            Node &node = nodes_[source];
+            if(node.window == NONE) {
+                windows_.push_back(Window());
+                node.window = windows_.size() - 1;
+            }
+            Window &window = windows_[node.window];
+            if(window.data.size() < length) window.data.resize(length);
+        }
+
+        /* разбор выражений */
+
+        static void skip_spaces(const std::string &text, size_t &pos) {
+            while(pos < text.size() && std::isspace((unsigned char)text[pos])) ++pos;
+        }
+
+        static bool parse_name(const std::string &text, size_t &pos, std::string &name) {
+            skip_spaces(text, pos);
+            const size_t start = pos;
+            while(pos < text.size() && (std::isalnum((unsigned char)text[pos]) || text[pos] == '_')) ++pos;
+            name = text.substr(start, pos - start);
+            return !name.empty() && !std::isdigit((unsigned char)name[0]);
+        }
+
+        static bool parse_number(const std::string &text, size_t &pos, T &value) {
+            skip_spaces(text, pos);
+            const char *start = text.c_str() + pos;
+            char *end = NULL;
+            value = (T)std::strtod(start, &end);
+            if(end == start) return false;
+            pos += end - start;
+            return true;
+        }
+
+        static bool parse_char(const std::string &text, size_t &pos, const char c) {
+            skip_spaces(text, pos);
+            if(pos >= text.size() || text[pos] != c) return false;
+            ++pos;
+            return true;
+        }
+
+        static bool parse_period(const std::string &text, size_t &pos, size_t &period) {
+            T value = 0;
+            if(!parse_char(text, pos, ',') || !parse_number(text, pos, value)) return false;
+            if(value < 1 || value != std::floor(value)) return false;
+            period = (size_t)value;
+            return true;
+        }
+
+        bool parse_expression(const std::string &text, size_t &pos, size_t &id) {
+            std::string name;
+            if(!parse_name(text, pos, name)) return false;
+            if(!parse_char(text, pos, '(')) {
+                for(size_t i = 0; i < inputs_.size(); ++i) {
+                    if(nodes_[inputs_[i]].key != name) continue;
+                    id = inputs_[i];
+                    return true;
+                }
+                return false;
+            }
+            for(size_t i = 0; i < name.size(); ++i) name[i] = std::toupper((unsigned char)name[i]);
+            size_t x = NONE;
+            if(!parse_expression(text, pos, x)) return false;
+            if(name == "GAIN" || name == "LOSS") {
+                if(!parse_char(text, pos, ')')) return false;
+                id = add_unique(make_key(name, x), name == "GAIN" ? NODE_GAIN : NODE_LOSS, x);
+                return true;
+            }
+            if(name == "ADD" || name == "SUB") {
+                size_t y = NONE;
+                if(!parse_char(text, pos, ',') || !parse_expression(text, pos, y) ||
+                    !parse_char(text, pos, ')')) return false;
+                id = add_unique(make_key(name, x, "," + nodes_[y].key), name == "ADD" ? NODE_ADD : NODE_SUB, x, y);
+                return true;
+            }
+            size_t period = 0;
+            if(!parse_period(text, pos, period)) return false;
+            const std::string period_arg = "," + to_string((T)period);
+            if(name == "BB_UPPER" || name == "BB_LOWER") {
+                T factor = 0;
+                if(!parse_char(text, pos, ',') || !parse_number(text, pos, factor) ||
+                    !parse_char(text, pos, ')') || period < 2) return false;
+                const size_t std_dev = add_stddev(x, period);
+                id = add_unique(make_key(name, x, period_arg + "," + to_string(factor)),
+                    name == "BB_UPPER" ? NODE_BB_UPPER : NODE_BB_LOWER, x, std_dev, period, factor);
+                return true;
+            }
+            if(!parse_char(text, pos, ')')) return false;
+            const std::string key = make_key(name, x, period_arg);
+            if(name == "SMA") id = add_unique(key, NODE_SMA, x, NONE, period);
+            else if(name == "EMA") id = add_unique(key, NODE_EMA, x, NONE, period);
+            else if(name == "MMA") id = add_unique(key, NODE_MMA, x, NONE, period);
+            else if(name == "WMA") id = add_unique(key, NODE_WMA, x, NONE, period);
+            else if(name == "STDDEV") {
+                if(period < 2) return false;
+                id = add_stddev(x, period);
+            } else if(name == "RSI") {
+                const size_t gain = add_unique(make_key("GAIN", x), NODE_GAIN, x);
+                const size_t loss = add_unique(make_key("LOSS", x), NODE_LOSS, x);
+                const size_t u = add_unique(make_key("SMA", gain, period_arg), NODE_SMA, gain, NONE, period);
+                const size_t d = add_unique(make_key("SMA", loss, period_arg), NODE_SMA, loss, NONE, period);
+                id = add_unique(key, NODE_RSI, u, d, period);
+            } else return false;
+            return true;
+        }
+
+        size_t add_stddev(const size_t x, const size_t period) {
+            const std::string period_arg = "," + to_string((T)period);
+            const size_t mean = add_unique(make_key("SMA", x, period_arg), NODE_SMA, x, NONE, period);
+            return add_unique(make_key("STDDEV", x, period_arg), NODE_STDDEV, x, mean, period);
+        }
+
+        /** \brief Вычислить узел
+         */
+        inline void calc_node(Node &node) {
+            const Node &x = nodes_[node.input[0]];
+            if(!x.is_ready) return;
+            switch(node.type) {
+            case NODE_SMA: {
+                    const Window &window = windows_[x.window];
+                    if(node.count < node.period) {
+                        ++node.count;
+                        if(node.count < node.period) return;
+                        T sum = 0;
+                        for(size_t i = node.period; i > 0; --i) sum += window.get(i - 1);
+                        node.sum = sum;
+                    } else {
+                        node.sum = node.sum + (x.value - window.get(node.period));
+                    }
+                    node.value = node.sum / (T)node.period;
+                    node.is_ready = true;
+                }
+                break;
+            case NODE_EMA:
+            case NODE_MMA:
+                if(node.count < node.period) {
+                    node.sum += x.value;
+                    ++node.count;
+                    if(node.count == node.period) node.prev = node.sum / (T)node.period;
+                } else {
+                    const T a = node.type == NODE_EMA ?
+                        (T)(2.0/((T)node.period + 1.0)) : (T)(1.0/(T)node.period);
+                    node.prev = a * x.value + (1.0 - a) * node.prev;
+                    node.value = node.prev;
+                    node.is_ready = true;
+                }
+                break;
+            case NODE_WMA: {
+                    if(node.count < node.period) {
+                        ++node.count;
+                        if(node.count < node.period) return;
+                    }
+                    const Window &window = windows_[x.window];
+                    T sum = 0;
+                    for(size_t i = node.period; i > 0; --i) {
+                        sum += window.get(node.period - i) * (T)i;
+                    }
+                    node.value = (sum * 2.0) / ((T)node.period * ((T)node.period + 1.0));
+                    node.is_ready = true;
+                }
+                break;
+            case NODE_STDDEV: {
+                    const Node &mean = nodes_[node.input[1]];
+                    if(!mean.is_ready) return;
+                    const Window &window = windows_[x.window];
+                    T sum = 0;
+                    for(size_t i = 0; i < node.period; ++i) {
+                        const T diff = window.get(i) - mean.value;
+                        sum += diff * diff;
+                    }
+                    node.value = std::sqrt(sum / (T)(node.period - 1));
+                    node.is_ready = true;
+                }
+                break;
+            case NODE_BB_UPPER:
+            case NODE_BB_LOWER: {
+                    const Node &std_dev = nodes_[node.input[1]];
+                    if(!std_dev.is_ready) return;
+                    const T mean = nodes_[std_dev.input[1]].value;
+                    node.value = node.type == NODE_BB_UPPER ?
+                        std_dev.value * node.factor + mean :
+                        mean - std_dev.value * node.factor;
+                    node.is_ready = true;
+                }
+                break;
+            case NODE_GAIN:
+            case NODE_LOSS:
+                if(node.count == 0) {
+                    node.count = 1;
+                } else {
+                    const T diff = node.type == NODE_GAIN ? x.value - node.prev : node.prev - x.value;
+                    node.value = diff > 0 ? diff : 0;
+                    node.is_ready = true;
+                }
+                node.prev = x.value;
+                break;
+            case NODE_RSI: {
+                    const Node &d = nodes_[node.input[1]];
+                    if(!d.is_ready) return;
+                    if(d.value == 0) {
+                        node.value = 100.0;
+                    } else {
+                        const T rs = x.value / d.value;
+                        node.value = 100.0 - (100.0 / (1.0 + rs));
+                    }
+                    node.is_ready = true;
+                }
+                break;
+            case NODE_ADD:
+            case NODE_SUB: {
+                    const Node &y = nodes_[node.input[1]];
+                    if(!y.is_ready) return;
+                    node.value = node.type == NODE_ADD ? x.value + y.value : x.value - y.value;
+                    node.is_ready = true;
+                }
+                break;
+            default:
+                break;
+            }
+        }
+
+    public:
+
+        IndicatorGraph() {};
+
+        /** \brief Добавить входной ряд
+         * \param name имя ряда, например "close"
+         * \param id номер узла ряда
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int add_input(const std::string &name, size_t &id) {
+            size_t pos = 0;
+            std::string checked_name;
+            if(!parse_name(name, pos, checked_name) || checked_name != name) return INVALID_PARAMETER;
+            typename std::map<std::string, size_t>::const_iterator it = keys_.find(name);
+            if(it != keys_.end()) {
+                id = it->second;
+                return OK;
+            }
+            Node node;
+            node.type = NODE_INPUT;
+            node.key = name;
+            nodes_.push_back(node);
+            id = nodes_.size() - 1;
+            keys_[name] = id;
+            inputs_.push_back(id);
+            clear();
+            return OK;
+        }
+
+        /** \brief Добавить индикатор
+         *
+         * Если такой узел уже есть, вернет его номер. Добавление нового
+         * узла сбрасывает состояние графа, ошибочное выражение граф не меняет
+         * \param expression выражение, например "BB_UPPER(close,20,2)"
+         * \param id номер узла индикатора
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int add(const std::string &expression, size_t &id) {
+            const size_t num_nodes = nodes_.size();
+            const size_t num_windows = windows_.size();
+            std::vector<size_t> window_sizes(num_windows);
+            for(size_t i = 0; i < num_windows; ++i) window_sizes[i] = windows_[i].data.size();
+            size_t pos = 0;
+            size_t node = NONE;
+            bool is_parsed = parse_expression(expression, pos, node);
+            skip_spaces(expression, pos);
+            if(!is_parsed || pos != expression.size()) {
+                /* убираем узлы, добавленные до ошибки */
+                for(size_t i = num_nodes; i < nodes_.size(); ++i) keys_.erase(nodes_[i].key);
+                nodes_.resize(num_nodes);
+                windows_.resize(num_windows);
+                for(size_t i = 0; i < num_windows; ++i) windows_[i].data.resize(window_sizes[i]);
+                for(size_t i = 0; i < nodes_.size(); ++i) {
+                    if(nodes_[i].window != NONE && nodes_[i].window >= num_windows) nodes_[i].window = NONE;
+                }
+                return INVALID_PARAMETER;
+            }
+            /* новые узлы и окна начинают с пустого состояния вместе со всем графом */
+            if(nodes_.size() != num_nodes) clear();
+            id = node;
+            return OK;
+        }
+
+        /** \brief Обновить состояние графа
+         * \param inputs значения входных рядов в порядке их добавления
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <class T1>
+        int update(const T1 &inputs) {
+            if(inputs_.empty()) return NO_INIT;
+            if(inputs.size() != inputs_.size()) return INVALID_PARAMETER;
+            for(size_t i = 0; i < inputs_.size(); ++i) {
+                Node &node = nodes_[inputs_[i]];
+                node.value = inputs[i];
+                node.is_ready = true;
+            }
+            for(size_t i = 0; i < nodes_.size(); ++i) {
+                Node &node = nodes_[i];
+                if(node.type != NODE_INPUT) calc_node(node);
+                if(node.window != NONE && node.is_ready) windows_[node.window].push(node.value);
+            }
+            return OK;
+        }
+
+        /** \brief Получить значение узла
+         * \param id номер узла
+         * \param out значение узла
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int get(const size_t id, T &out) const {
+            if(id >= nodes_.size()) return INVALID_PARAMETER;
+            out = nodes_[id].value;
+            return nodes_[id].is_ready ? OK : INDICATOR_NOT_READY_TO_WORK;
+        }
+
+        /** \brief Получить выражение узла в каноническом виде
+         * \param id номер узла
+         * \return выражение узла
+         */
+        std::string get_key(const size_t id) const {
+            return id < nodes_.size() ? nodes_[id].key : std::string();
+        }
+
+        /** \brief Получить количество узлов графа
+         */
+        inline size_t get_num_nodes() const {
+            return nodes_.size();
+        }
+
+        /** \brief Получить количество общих окон графа
+         */
+        inline size_t get_num_windows() const {
+            return windows_.size();
+        }
+
+        /** \brief Очистить состояние графа
+         *
+         * Узлы графа сохраняются
+         */
+        void clear() {
+            for(size_t i = 0; i < nodes_.size(); ++i) {
+                Node &node = nodes_[i];
+                node.value = 0;
+                node.sum = 0;
+                node.prev = 0;
+                node.count = 0;
+                node.is_ready = false;
+            }
+            for(size_t i = 0; i < windows_.size(); ++i) {
+                windows_[i].pos = 0;
+                windows_[i].count = 0;
+            }
+        }
+    };
+}
+
+#endif // XTECHNICAL_INDICATOR_GRAPH_HPP_INCLUDED
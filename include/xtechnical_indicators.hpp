@@ -304,6 +304,44 @@ namespace xtechnical_indicators {
             return INDICATOR_NOT_READY_TO_WORK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (period_ == 0 || data_.count() < period_); ++i) {
+                err = update(in[i], out[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            /* окно заполнено: выходящее из окна значение берется из буфера,
+             * а затем прямо из входного массива
+             */
+            const size_t start = i;
+            const size_t ring_end = std::min(size, start + period_);
+            T sum = last_data_;
+            for(; i < ring_end; ++i) {
+                sum = sum + (in[i] - data_[i - start]);
+                out[i] = sum / (T)period_;
+            }
+            for(; i < size; ++i) {
+                sum = sum + (in[i] - in[i - period_]);
+                out[i] = sum / (T)period_;
+            }
+            last_data_ = sum;
+            for(i = size - std::min(size - start, period_); i < size; ++i) {
+                data_.push(in[i]);
+            }
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -635,6 +673,34 @@ namespace xtechnical_indicators {
             return INDICATOR_NOT_READY_TO_WORK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (period_ == 0 || data_.size() < period_); ++i) {
+                err = update(in[i], out[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            /* окна идут подряд в одном массиве: без сдвига буфера на каждом шаге */
+            const size_t start = i;
+            std::vector<T> buffer(data_.begin() + 1, data_.end());
+            buffer.insert(buffer.end(), in + start, in + size);
+            for(size_t j = 0; i < size; ++i, ++j) {
+                out[i] = std::accumulate(buffer.begin() + j, buffer.begin() + j + period_, (T)0);
+            }
+            data_.assign(buffer.end() - period_, buffer.end());
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -730,6 +796,40 @@ namespace xtechnical_indicators {
             return INDICATOR_NOT_READY_TO_WORK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (period_ == 0 || data_.size() < period_); ++i) {
+                err = update(in[i], out[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            /* окна идут подряд в одном массиве: без сдвига буфера на каждом шаге */
+            const size_t start = i;
+            std::vector<T> buffer(data_.begin() + 1, data_.end());
+            buffer.insert(buffer.end(), in + start, in + size);
+            const T divider = ((T)period_ * ((T)period_ + 1.0));
+            for(size_t j = 0; i < size; ++i, ++j) {
+                const T *window = buffer.data() + j;
+                T sum = 0;
+                for(size_t k = period_; k > 0; k--) {
+                    sum += window[k - 1] * (T)k;
+                }
+                out[i] = (sum * 2.0) / divider;
+            }
+            data_.assign(buffer.end() - period_, buffer.end());
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -737,25 +837,58 @@ namespace xtechnical_indicators {
         }
     };
 
-    /** \brief Экспоненциально взвешенное скользящее среднее
+    /** \brief Коэффициент сглаживания EMA: 2 / (period + 1)
      */
-    template <class T>
-    class EMA {
+    class EmaAlpha {
+    public:
+        template <class T>
+        static inline T calc(const size_t period) {
+            return 2.0/(T)(period + 1.0);
+        }
+    };
+
+    /** \brief Коэффициент сглаживания Уайлдера (MMA): 1 / period
+     */
+    class WilderAlpha {
+    public:
+        template <class T>
+        static inline T calc(const size_t period) {
+            return 1.0/(T)period;
+        }
+    };
+
+    /** \brief Экспоненциальное сглаживание
+     *
+     * Коэффициент сглаживания задается политикой ALPHA_POLICY, поэтому
+     * методы не виртуальные и встраиваются в составные индикаторы
+     * (RSI, MFI, OsMa). Первые period значений дают начальное среднее
+     * \tparam ALPHA_POLICY класс со статическим методом calc<T>(period),
+     * например EmaAlpha или WilderAlpha
+     */
+    template <class T, class ALPHA_POLICY = EmaAlpha>
+    class ExponentialSmoothing {
     protected:
         std::vector<T> data_;
-        T last_data_;
-        T a;
+        T last_data_ = 0;
+        T a = 0;
         size_t period_ = 0;
     public:
-        EMA() {};
+        ExponentialSmoothing() {};
 
-        /** \brief Инициализировать экспоненциально взвешенное
-         * скользящее среднее
+        /** \brief Инициализировать экспоненциальное сглаживание
          * \param period период
          */
-        EMA(const size_t period) : period_(period) {
+        ExponentialSmoothing(const size_t period) : period_(period) {
+            data_.reserve(period_);
+            a = ALPHA_POLICY::template calc<T>(period_);
+        }
+
+        /** \brief Инициализировать экспоненциальное сглаживание с заданным коэффициентом
+         * \param period период начального среднего
+         * \param alpha коэффициент сглаживания
+         */
+        ExponentialSmoothing(const size_t period, const T alpha) : a(alpha), period_(period) {
             data_.reserve(period_);
-            a = 2.0/(T)(period_ + 1.0d);
         }
 
         /** \brief Обновить состояние индикатора
@@ -763,7 +896,7 @@ namespace xtechnical_indicators {
          * \param out сигнал на выходе
          * \return вернет 0 в случае успеха, иначе см. ErrorType
          */
-        virtual int update(const T in, T &out) {
+        inline int update(const T in, T &out) {
             if(period_ == 0) {
                 out = in;
                 return NO_INIT;
@@ -804,6 +937,34 @@ namespace xtechnical_indicators {
             return INDICATOR_NOT_READY_TO_WORK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (period_ == 0 || data_.size() < period_); ++i) {
+                err = update(in[i], out[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            const size_t start = i;
+            const T b = 1.0 - a;
+            T value = last_data_;
+            for(; i < size; ++i) {
+                value = a * in[i] + b * value;
+                out[i] = value;
+            }
+            last_data_ = value;
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -811,21 +972,31 @@ namespace xtechnical_indicators {
         }
     };
 
+    /** \brief Экспоненциально взвешенное скользящее среднее
+     */
+    template <class T>
+    class EMA : public ExponentialSmoothing<T, EmaAlpha> {
+    public:
+        EMA() {};
+
+        /** \brief Инициализировать экспоненциально взвешенное
+         * скользящее среднее
+         * \param period период
+         */
+        EMA(const size_t period) : ExponentialSmoothing<T, EmaAlpha>(period) {}
+    };
+
     /** \brief Модифицированное скользящее среднее
      */
     template <class T>
-    class MMA : public EMA<T> {
+    class MMA : public ExponentialSmoothing<T, WilderAlpha> {
     public:
         MMA() {};
 
         /** \brief Инициализировать модифицированное скользящее среднее
          * \param period период
          */
-        MMA(const size_t period) {
-            EMA<T>::period_ = period;
-            EMA<T>::data_.reserve(period);
-            EMA<T>::a = 1.0/(T)period;
-        }
+        MMA(const size_t period) : ExponentialSmoothing<T, WilderAlpha>(period) {}
     };
 
     /** \brief Индикатор Volume Weighted MA - модифицированная скользящая средняя, с реализацией взвешенности по объему.
@@ -932,6 +1103,55 @@ namespace xtechnical_indicators {
             return OK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param input сигналы на входе
+         * \param weight веса сигналов на входе
+         * \param output сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *input, const T *weight, T *output, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (period == 0 || price_data.size() + 1 < period); ++i) {
+                err = update(input[i], weight[i], output[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            /* окна идут подряд в одном массиве: без сдвига буфера на каждом шаге */
+            const size_t start = i;
+            const size_t skip = price_data.size() + 1 - period;
+            std::vector<T> prices(price_data.begin() + skip, price_data.end());
+            std::vector<T> weights(weight_data.begin() + skip, weight_data.end());
+            prices.insert(prices.end(), input + start, input + size);
+            weights.insert(weights.end(), weight + start, weight + size);
+            for(size_t j = 0; i < size; ++i, ++j) {
+                const T *price_window = prices.data() + j;
+                const T *weight_window = weights.data() + j;
+                T sum = 0;
+                T sum_weight = 0;
+                for(size_t k = 0; k < period; ++k) {
+                    sum += price_window[k] * weight_window[k];
+                    sum_weight += weight_window[k];
+                }
+                if(sum_weight == 0) {
+                    sum = 0;
+                    for(size_t k = 0; k < period; ++k) {
+                        sum += price_window[k];
+                    }
+                    output[i] = sum / (T)period;
+                } else {
+                    output[i] = sum / (sum_weight);
+                }
+            }
+            price_data.assign(prices.end() - period, prices.end());
+            weight_data.assign(weights.end() - period, weights.end());
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -1024,6 +1244,33 @@ namespace xtechnical_indicators {
             return OK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (!is_init_ || !is_update_); ++i) {
+                err = update(in[i], out[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            const size_t start = i;
+            T value = prev_;
+            for(; i < size; ++i) {
+                value = alfa_ * value + beta_ * in[i];
+                out[i] = value;
+            }
+            prev_ = value;
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -1172,6 +1419,61 @@ namespace xtechnical_indicators {
             return OK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         *
+         * Тип INDICATOR_TYPE должен поддерживать update_batch
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            if(!is_init_) {
+                if(status) std::fill(status, status + size, (int)NO_INIT);
+                return NO_INIT;
+            }
+            size_t start = 0;
+            if(!is_update_) {
+                prev_ = in[0];
+                is_update_ = true;
+                out[0] = 50.0;
+                if(status) status[0] = INDICATOR_NOT_READY_TO_WORK;
+                if(size == 1) return INDICATOR_NOT_READY_TO_WORK;
+                start = 1;
+            }
+            /* рост и падение считаются блоками, которые помещаются в кэш */
+            enum {
+                BLOCK_SIZE = 256,
+            };
+            T u[BLOCK_SIZE], d[BLOCK_SIZE], mu[BLOCK_SIZE], md[BLOCK_SIZE];
+            int erru[BLOCK_SIZE], errd[BLOCK_SIZE];
+            int err = OK;
+            for(size_t pos = start; pos < size; pos += BLOCK_SIZE) {
+                const size_t n = std::min((size_t)BLOCK_SIZE, size - pos);
+                T prev = prev_;
+                for(size_t i = 0; i < n; ++i) {
+                    const T value = in[pos + i];
+                    const T diff = value - prev;
+                    u[i] = diff > 0 ? diff : (T)0;
+                    d[i] = diff < 0 ? -diff : (T)0;
+                    prev = value;
+                }
+                prev_ = prev;
+                iU.update_batch(u, mu, erru, n);
+                iD.update_batch(d, md, errd, n);
+                for(size_t i = 0; i < n; ++i) {
+                    const bool is_ready = erru[i] == OK && errd[i] == OK;
+                    const T rsi = md[i] == 0 ? (T)100.0 : (T)(100.0 - (100.0 / (1.0 + mu[i] / md[i])));
+                    out[pos + i] = is_ready ? rsi : (T)50.0;
+                    err = is_ready ? (int)OK : (int)INDICATOR_NOT_READY_TO_WORK;
+                    if(status) status[pos + i] = err;
+                }
+            }
+            return err;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -1199,6 +1501,87 @@ namespace xtechnical_indicators {
         return OK;
     }
 
+    /** \brief Обработчик массива данных RSI по кругу
+     *
+     * Дает тот же результат, что и calc_ring_rsi, но хранит индикатор и
+     * результаты между вызовами. Если массив сдвинулся на один элемент
+     * (старый удален из начала, новый добавлен в конец), пересчитываются
+     * только period + 1 значений, зависящих от нового элемента
+     */
+    template <class T>
+    class RingRSI {
+    private:
+        RSI<T,SMA<T>> iRSI;
+        std::vector<T> data_;   /**< результаты прошлого вызова, начало в offset_ */
+        size_t period_ = 0;
+        size_t offset_ = 0;
+        bool is_init_ = false;
+
+        inline T &at(const size_t index) {
+            const size_t pos = offset_ + index;
+            return data_[pos < data_.size() ? pos : pos - data_.size()];
+        }
+
+    public:
+        RingRSI() {};
+
+        /** \brief Инициализировать обработчик
+         * \param period период индикатора
+         */
+        RingRSI(const size_t &period) : iRSI(period), period_(period) {}
+
+        /** \brief Обработать массив данных
+         * \param in входные данные
+         * \param out выходные данные, размер равен in
+         * \param is_shift массив in равен массиву прошлого вызова, сдвинутому на
+         * один элемент, с новым элементом в конце. Укажите false при разрыве данных,
+         * тогда массив будет пересчитан полностью
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <class T1, class T2>
+        int update(const T1 &in, T2 &out, const bool is_shift = true) {
+            if(period_ == 0) return NO_INIT;
+            const size_t input_size = in.size();
+            if( input_size == 0 || input_size < period_ ||
+                out.size() != input_size)
+                return INVALID_PARAMETER;
+            const size_t depth = period_ + 1;
+            iRSI.clear();
+            if(!is_shift || !is_init_ || data_.size() != input_size ||
+                input_size < 2 * depth) {
+                data_.resize(input_size);
+                offset_ = 0;
+                for(size_t i = input_size - period_; i < input_size; ++i) {
+                    iRSI.update(in[i]);
+                }
+                for(size_t i = 0; i < input_size; ++i) {
+                    iRSI.update(in[i], data_[i]);
+                }
+            } else {
+                offset_ = offset_ + 1 < input_size ? offset_ + 1 : 0;
+                for(size_t i = input_size - depth; i < input_size - 1; ++i) {
+                    iRSI.update(in[i]);
+                }
+                iRSI.update(in[input_size - 1], at(input_size - 1));
+                for(size_t i = 0; i < depth - 1; ++i) {
+                    iRSI.update(in[i], at(i));
+                }
+            }
+            is_init_ = true;
+            std::copy(data_.begin() + offset_, data_.end(), out.begin());
+            std::copy(data_.begin(), data_.begin() + offset_, out.begin() + (input_size - offset_));
+            return OK;
+        }
+
+        /** \brief Очистить данные обработчика
+         */
+        void clear() {
+            is_init_ = false;
+            offset_ = 0;
+            iRSI.clear();
+        }
+    };
+
     /** \brief Линии Боллинджера
      */
     template <typename T>
@@ -1403,6 +1786,48 @@ namespace xtechnical_indicators {
             return OK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param in сигналы на входе
+         * \param tl верхняя полоса боллинджера
+         * \param ml скользящее среднее
+         * \param bl нижняя полоса боллинджера
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *tl, T *ml, T *bl, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (period_ == 0 || data_.size() + 1 < (size_t)period_); ++i) {
+                err = update(in[i], tl[i], ml[i], bl[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            /* окна идут подряд в одном массиве: без сдвига буфера на каждом шаге */
+            const size_t start = i;
+            const size_t skip = data_.size() + 1 - period_;
+            std::vector<T> buffer(data_.begin() + skip, data_.end());
+            buffer.insert(buffer.end(), in + start, in + size);
+            for(size_t j = 0; i < size; ++i, ++j) {
+                const T *window = buffer.data() + j;
+                T mean = std::accumulate(window, window + period_, T(0));
+                mean /= (T)period_;
+                T sum = 0;
+                for (size_t k = 0; k < period_; ++k) {
+                    T diff = (window[k] - mean);
+                    sum +=  diff * diff;
+                }
+                T std_dev = std::sqrt(sum / (T)(period_ - 1));
+                ml[i] = mean;
+                tl[i] = std_dev * d_ + mean;
+                bl[i] = mean - std_dev * d_;
+            }
+            data_.assign(buffer.end() - period_, buffer.end());
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -1436,6 +1861,104 @@ namespace xtechnical_indicators {
         return OK;
     }
 
+    /** \brief Обработчик массива данных боллинджером по кругу
+     *
+     * Дает тот же результат, что и calc_ring_bollinger, но хранит индикатор
+     * и результаты между вызовами. Если массив сдвинулся на один элемент
+     * (старый удален из начала, новый добавлен в конец), пересчитываются
+     * только period значений, зависящих от нового элемента
+     */
+    template <class T>
+    class RingBollinger {
+    private:
+        BollingerBands<T> iBB;
+        std::vector<T> tl_;     /**< результаты прошлого вызова, начало в offset_ */
+        std::vector<T> ml_;
+        std::vector<T> bl_;
+        size_t period_ = 0;
+        size_t offset_ = 0;
+        bool is_init_ = false;
+
+        inline size_t index(const size_t i) const {
+            const size_t pos = offset_ + i;
+            return pos < tl_.size() ? pos : pos - tl_.size();
+        }
+
+        template <class T1>
+        inline void copy_ring(const std::vector<T> &data, T1 &out) const {
+            std::copy(data.begin() + offset_, data.end(), out.begin());
+            std::copy(data.begin(), data.begin() + offset_, out.begin() + (data.size() - offset_));
+        }
+
+    public:
+        RingBollinger() {};
+
+        /** \brief Инициализировать обработчик
+         * \param period период индикатора
+         * \param std_dev_factor множитель стандартного отклонения
+         */
+        RingBollinger(const size_t &period, const T &std_dev_factor) :
+            iBB(period, std_dev_factor), period_(period) {}
+
+        /** \brief Обработать массив данных
+         * \param in входные данные
+         * \param tl верхняя полоса
+         * \param ml средняя линия
+         * \param bl нижняя полоса
+         * \param is_shift массив in равен массиву прошлого вызова, сдвинутому на
+         * один элемент, с новым элементом в конце. Укажите false при разрыве данных,
+         * тогда массив будет пересчитан полностью
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <class T1, class T2>
+        int update(const T1 &in, T2 &tl, T2 &ml, T2 &bl, const bool is_shift = true) {
+            if(period_ == 0) return NO_INIT;
+            const size_t input_size = in.size();
+            const size_t tl_size = tl.size();
+            if( input_size == 0 || input_size < period_ ||
+                tl_size != bl.size() || tl_size != input_size ||
+                ml.size() != input_size) return INVALID_PARAMETER;
+            iBB.clear();
+            if(!is_shift || !is_init_ || tl_.size() != input_size ||
+                input_size < 2 * period_) {
+                tl_.resize(input_size);
+                ml_.resize(input_size);
+                bl_.resize(input_size);
+                offset_ = 0;
+                for(size_t i = input_size - period_; i < input_size; ++i) {
+                    iBB.update(in[i]);
+                }
+                for(size_t i = 0; i < input_size; ++i) {
+                    iBB.update(in[i], tl_[i], ml_[i], bl_[i]);
+                }
+            } else {
+                offset_ = offset_ + 1 < input_size ? offset_ + 1 : 0;
+                for(size_t i = input_size - period_; i < input_size - 1; ++i) {
+                    iBB.update(in[i]);
+                }
+                size_t pos = index(input_size - 1);
+                iBB.update(in[input_size - 1], tl_[pos], ml_[pos], bl_[pos]);
+                for(size_t i = 0; i + 1 < period_; ++i) {
+                    pos = index(i);
+                    iBB.update(in[i], tl_[pos], ml_[pos], bl_[pos]);
+                }
+            }
+            is_init_ = true;
+            copy_ring(tl_, tl);
+            copy_ring(ml_, ml);
+            copy_ring(bl_, bl);
+            return OK;
+        }
+
+        /** \brief Очистить данные обработчика
+         */
+        void clear() {
+            is_init_ = false;
+            offset_ = 0;
+            iBB.clear();
+        }
+    };
+
     /** \brief Средняя скорость
      */
     template <typename T>
@@ -1506,8 +2029,12 @@ namespace xtechnical_indicators {
         MW<T> iMW;
         const size_t MIN_WAVEFORM_LEN = 3;
         T coeff_exp = 3.141592;
-        std::vector<std::vector<T>> exp_data_up_;
-        std::vector<std::vector<T>> exp_data_dn_;
+        std::vector<std::vector<T>> exp_rank_up_;   /**< Ранги эталонов, считаются один раз */
+        std::vector<std::vector<T>> exp_rank_dn_;
+        std::vector<T> exp_d_up_;                   /**< Поправки на одинаковые ранги эталонов */
+        std::vector<T> exp_d_dn_;
+        std::vector<T> fragment_rank_;
+        std::vector<size_t> rank_index_;
 
         void init_exp_data_up(std::vector<T> &data) {
             T dt = 1.0/(T)data.size();
@@ -1535,47 +2062,54 @@ namespace xtechnical_indicators {
          * \param max_len максимальная длина файла
          */
         DetectorWaveform(const int max_len) : iMW(max_len) {
-            if(max_len < MIN_WAVEFORM_LEN) return;
+            if(max_len < (int)MIN_WAVEFORM_LEN) return;
             size_t max_num_exp_data = max_len - MIN_WAVEFORM_LEN + 1;
-            exp_data_up_.resize(max_num_exp_data);
-            exp_data_dn_.resize(max_num_exp_data);
-            for(size_t l = MIN_WAVEFORM_LEN; l <= max_len; ++l) {
-                exp_data_up_[l-MIN_WAVEFORM_LEN].resize(l);
-                exp_data_dn_[l-MIN_WAVEFORM_LEN].resize(l);
-                init_exp_data_up(exp_data_up_[l-MIN_WAVEFORM_LEN]);
-                init_exp_data_dn(exp_data_dn_[l-MIN_WAVEFORM_LEN]);
-            }
+            exp_rank_up_.resize(max_num_exp_data);
+            exp_rank_dn_.resize(max_num_exp_data);
+            exp_d_up_.resize(max_num_exp_data);
+            exp_d_dn_.resize(max_num_exp_data);
+            std::vector<T> exp_data;
+            for(size_t l = MIN_WAVEFORM_LEN; l <= (size_t)max_len; ++l) {
+                const size_t n = l - MIN_WAVEFORM_LEN;
+                exp_data.resize(l);
+                init_exp_data_up(exp_data);
+                exp_d_up_[n] = xtechnical_correlation::calculate_spearman_ranks(
+                    exp_data.data(), l, exp_rank_up_[n], rank_index_);
+                init_exp_data_dn(exp_data);
+                exp_d_dn_[n] = xtechnical_correlation::calculate_spearman_ranks(
+                    exp_data.data(), l, exp_rank_dn_[n], rank_index_);
+            }
+            fragment_rank_.reserve(max_len);
+            rank_index_.reserve(max_len);
         }
 
         int update(T in, T &out, const int len_waveform) {
-            std::vector<T> mw_out;
-            int err = iMW.update(in, mw_out);
+            int err = iMW.update(in);
             if(err == OK) {
-                if(mw_out.size() >= MIN_WAVEFORM_LEN &&
-                    len_waveform <= mw_out.size()) {
-                    std::vector<T> fragment_data;
-                    fragment_data.insert(
-                        fragment_data.begin(),
-                        mw_out.begin() + mw_out.size() - len_waveform,
-                        mw_out.end());
-                    int err_n = xtechnical_normalization::calculate_min_max(
-                        fragment_data,
-                        fragment_data,
-                        MINMAX_UNSIGNED);
-                    if(err_n != OK) return err_n;
-                    T coeff_up = 0, coeff_dn = 0;
-                    int err_up = xtechnical_correlation::calculate_spearman_rank_correlation_coefficient(
-                        fragment_data,
-                        exp_data_up_[len_waveform-MIN_WAVEFORM_LEN],
-                        coeff_up);
-
-                    int err_dn = xtechnical_correlation::calculate_spearman_rank_correlation_coefficient(
-                        fragment_data,
-                        exp_data_dn_[len_waveform-MIN_WAVEFORM_LEN],
-                        coeff_dn);
-                    if(err_up != OK) return err_up;
-                    if(err_dn != OK) return err_dn;
-                    if(abs(coeff_up) > abs(coeff_dn)) {
+                const std::vector<T> &mw_data = iMW.get_data();
+                if(len_waveform < (int)MIN_WAVEFORM_LEN) return INVALID_PARAMETER;
+                if(mw_data.size() >= MIN_WAVEFORM_LEN &&
+                    (size_t)len_waveform <= mw_data.size()) {
+                    /* ранги не меняются при MinMax нормализации,
+                     * поэтому фрагмент ранжируется напрямую и один раз
+                     */
+                    const T d_fragment = xtechnical_correlation::calculate_spearman_ranks(
+                        mw_data.data() + mw_data.size() - len_waveform,
+                        (size_t)len_waveform,
+                        fragment_rank_,
+                        rank_index_);
+                    const size_t n = len_waveform - MIN_WAVEFORM_LEN;
+                    const T coeff_up = xtechnical_correlation::calculate_spearman_coefficient_from_ranks(
+                        fragment_rank_,
+                        d_fragment,
+                        exp_rank_up_[n],
+                        exp_d_up_[n]);
+                    const T coeff_dn = xtechnical_correlation::calculate_spearman_coefficient_from_ranks(
+                        fragment_rank_,
+                        d_fragment,
+                        exp_rank_dn_[n],
+                        exp_d_dn_[n]);
+                    if(std::abs(coeff_up) > std::abs(coeff_dn)) {
                         out = coeff_up;
                     } else {
                         out = coeff_dn;
@@ -1899,6 +2433,26 @@ namespace xtechnical_indicators {
             return err_std_dev;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         *
+         * Каждый шаг зависит от предыдущего и от фильтра, поэтому это
+         * цикл по update без промежуточных вызовов со стороны пользователя
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return xtechnical_common::INVALID_PARAMETER;
+            int err = xtechnical_common::OK;
+            for(size_t i = 0; i < size; ++i) {
+                err = update(in[i], out[i]);
+                if(status) status[i] = err;
+            }
+            return err;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -2152,6 +2706,39 @@ namespace xtechnical_indicators {
             return INDICATOR_NOT_READY_TO_WORK;
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         * \param in сигналы на входе
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *in, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            size_t i = 0;
+            int err = OK;
+            for(; i < size && (buffer_size == 0 || buffer.size() + 1 < buffer_size); ++i) {
+                err = update(in[i], out[i]);
+                if(status) status[i] = err;
+            }
+            if(i == size) return err;
+            /* каждый выход зависит только от двух входов, цикл без зависимостей */
+            const size_t start = i;
+            const size_t skip = buffer.size() + 1 - buffer_size;
+            std::vector<T> data(buffer.begin() + skip, buffer.end());
+            data.insert(data.end(), in + start, in + size);
+            const size_t lag = buffer_size - 1;
+            for(size_t j = 0; i < size; ++i, ++j) {
+                const T front = data[j];
+                const T back = data[j + lag];
+                const T roc = ((back - front) / front) * 100.0;
+                out[i] = front == 0 ? (back > 0 ? (T)100 : (T)-100) : roc;
+            }
+            buffer.assign(data.end() - buffer_size, data.end());
+            if(status) std::fill(status + start, status + size, (int)OK);
+            return OK;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -2375,6 +2962,63 @@ namespace xtechnical_indicators {
             return test(price, volume, out);
         }
 
+        /** \brief Обновить состояние индикатора для массива данных
+         *
+         * Тип INDICATOR_TYPE должен поддерживать update_batch
+         * \param price цены, в оригинале используется типичная цена
+         * \param volume объемы торгов
+         * \param out сигналы на выходе
+         * \param status состояние индикатора для каждого сигнала (может быть NULL)
+         * \param size количество сигналов
+         * \return состояние индикатора после последнего сигнала, см. ErrorType
+         */
+        int update_batch(const T *price, const T *volume, T *out, int *status, const size_t size) {
+            if(size == 0) return INVALID_PARAMETER;
+            if(!is_init_) {
+                if(status) std::fill(status, status + size, (int)NO_INIT);
+                return NO_INIT;
+            }
+            size_t start = 0;
+            if(!is_update_) {
+                prev_ = price[0];
+                is_update_ = true;
+                out[0] = 50.0;
+                if(status) status[0] = INDICATOR_NOT_READY_TO_WORK;
+                if(size == 1) return INDICATOR_NOT_READY_TO_WORK;
+                start = 1;
+            }
+            /* потоки денег считаются блоками, которые помещаются в кэш */
+            enum {
+                BLOCK_SIZE = 256,
+            };
+            T u[BLOCK_SIZE], d[BLOCK_SIZE], mu[BLOCK_SIZE], md[BLOCK_SIZE];
+            int erru[BLOCK_SIZE], errd[BLOCK_SIZE];
+            int err = OK;
+            for(size_t pos = start; pos < size; pos += BLOCK_SIZE) {
+                const size_t n = std::min((size_t)BLOCK_SIZE, size - pos);
+                T prev = prev_;
+                for(size_t i = 0; i < n; ++i) {
+                    const T value = price[pos + i];
+                    /* поток необработанных денег */
+                    const T mf = value * volume[pos + i];
+                    u[i] = prev < value ? mf : (T)0;
+                    d[i] = prev > value ? mf : (T)0;
+                    prev = value;
+                }
+                prev_ = prev;
+                iU.update_batch(u, mu, erru, n);
+                iD.update_batch(d, md, errd, n);
+                for(size_t i = 0; i < n; ++i) {
+                    const bool is_ready = erru[i] == OK && errd[i] == OK;
+                    const T mfi = md[i] == 0 ? (T)100.0 : (T)(100.0 - (100.0 / (1.0 + mu[i] / md[i])));
+                    out[pos + i] = is_ready ? mfi : (T)50.0;
+                    err = is_ready ? (int)OK : (int)INDICATOR_NOT_READY_TO_WORK;
+                    if(status) status[pos + i] = err;
+                }
+            }
+            return err;
+        }
+
         /** \brief Очистить данные индикатора
          */
         void clear() {
@@ -166,6 +166,14 @@ namespace xtechnical_indicators {
             else buffer = data_;
         }
 
+        /** \brief Получить данные внутреннего буфера индикатора без копирования
+         * \return ссылка на буфер, действительна до следующего вызова update или test
+         */
+        const std::vector<T> &get_data() const {
+            if(is_test_) return data_test_;
+            return data_;
+        }
+
         /** \brief Получить максимальное значение буфера
          * \param max_value Максимальное значение
          * \param period Период максимальных данных
@@ -30,11 +30,73 @@
 #include <algorithm>
 #include <numeric>
 #include <cmath>
+#include <deque>
+#include <utility>
+#include <limits>
 
 namespace xtechnical_normalization {
     using namespace xtechnical_common;
 
+    /** \brief Найти минимум и максимум данных за один проход
+     *
+     * Проход ведется в несколько независимых аккумуляторов,
+     * что позволяет компилятору векторизовать цикл
+     * \param in входные данные
+     * \param min_value минимальное значение
+     * \param max_value максимальное значение
+     * \return вернет 0 в случае успеха, иначе см. xtechnical_common.hpp
+     */
+    template<class T1, class T2>
+    int calculate_min_max_values(const T1 &in, T2 &min_value, T2 &max_value) {
+        const size_t input_size = in.size();
+        if(input_size == 0) return INVALID_PARAMETER;
+        using NumType = typename T1::value_type;
+        const size_t LANES = 4;
+        NumType min_lane[LANES], max_lane[LANES];
+        for(size_t l = 0; l < LANES; ++l) {
+            min_lane[l] = max_lane[l] = in[0];
+        }
+        size_t i = 0;
+        for(; i + LANES <= input_size; i += LANES) {
+            for(size_t l = 0; l < LANES; ++l) {
+                const NumType value = in[i + l];
+                min_lane[l] = value < min_lane[l] ? value : min_lane[l];
+                max_lane[l] = value > max_lane[l] ? value : max_lane[l];
+            }
+        }
+        for(; i < input_size; ++i) {
+            const NumType value = in[i];
+            min_lane[0] = value < min_lane[0] ? value : min_lane[0];
+            max_lane[0] = value > max_lane[0] ? value : max_lane[0];
+        }
+        min_value = (T2)*std::min_element(min_lane, min_lane + LANES);
+        max_value = (T2)*std::max_element(max_lane, max_lane + LANES);
+        return OK;
+    }
+
+    /** \brief Привести данные к диапазону по известным минимуму и амплитуде
+     *
+     * Тип нормализации выбирает только множитель и смещение,
+     * поэтому цикл не содержит ветвлений. Безопасно для in и out, указывающих на одни данные
+     * \param in входные данные
+     * \param out нормализованный вектор
+     * \param min_data минимальное значение
+     * \param ampl амплитуда (не равна 0)
+     * \param type тип нормализации (0 - нормализация данных к промежутку от 0 до 1, иначе от -1 до 1)
+     */
+    template<class T1, class T2, class T3>
+    void calculate_min_max_scale(const T1 &in, T2 &out, const T3 min_data, const T3 ampl, const int type) {
+        const size_t input_size = in.size();
+        const double gain = type == 0 ? 1.0 : 2.0;
+        const double offset = type == 0 ? 0.0 : -1.0;
+        for(size_t i = 0; i < input_size; i++) {
+            out[i] = gain * ((double)(in[i] - min_data) / ampl) + offset;
+        }
+    }
+
     /** \brief MinMax нормализация данных
+     *
+     * Можно использовать для нормализации на месте (in и out - один и тот же массив)
      * \param in входные данные для нормализации
      * \param out нормализованный вектор
      * \param type тип нормализации (0 - нормализация данных к промежутку от 0 до 1, иначе от -1 до 1)
@@ -45,19 +107,12 @@ namespace xtechnical_normalization {
         size_t input_size = in.size();
         size_t output_size = out.size();
         if(input_size == 0 || output_size != input_size) return INVALID_PARAMETER;
-        auto it_max_data = std::max_element(in.begin(), in.end());
-        auto it_min_data = std::min_element(in.begin(), in.end());
-        auto max_data = in[0];
-        auto min_data = in[0];
-        if(it_max_data != in.end() && it_min_data != in.end()) {
-            max_data = *it_max_data;
-            min_data = *it_min_data;
-        }
-        auto ampl = max_data - min_data;
+        using NumType = typename T1::value_type;
+        NumType min_data = 0, max_data = 0;
+        calculate_min_max_values(in, min_data, max_data);
+        const NumType ampl = max_data - min_data;
         if(ampl != 0) {
-            for(size_t i = 0; i < input_size; i++) {
-                out[i] = type == 0 ? (double)(in[i] - min_data) / ampl : 2.0 * ((double)(in[i] - min_data) / ampl) - 1.0;
-            }
+            calculate_min_max_scale(in, out, min_data, ampl, type);
         } else {
             std::fill(out.begin(), out.end(),0);
         }
@@ -65,6 +120,8 @@ namespace xtechnical_normalization {
     }
 
     /** \brief MinMax нормализация данных
+     *
+     * Можно использовать для нормализации на месте (in и out - один и тот же массив)
      * \param in входные данные для нормализации
      * \param out нормализованный вектор
      * \param min_value минимальное значение
@@ -77,22 +134,14 @@ namespace xtechnical_normalization {
         size_t input_size = in.size();
         size_t output_size = out.size();
         if(input_size == 0 || output_size != input_size) return INVALID_PARAMETER;
-        auto it_max_data = std::max_element(in.begin(), in.end());
-        auto it_min_data = std::min_element(in.begin(), in.end());
-        auto max_data = in[0];
-        auto min_data = in[0];
-        if(it_max_data != in.end() && it_min_data != in.end()) {
-            max_data = *it_max_data;
-            min_data = *it_min_data;
-        }
         using NumType = typename T1::value_type;
+        NumType min_data = 0, max_data = 0;
+        calculate_min_max_values(in, min_data, max_data);
         min_data = (NumType)std::min((NumType)min_value, (NumType)min_data);
         max_data = (NumType)std::max((NumType)max_value, (NumType)max_data);
-        auto ampl = max_data - min_data;
+        const NumType ampl = max_data - min_data;
         if(ampl != 0) {
-            for(size_t i = 0; i < input_size; i++) {
-                out[i] = type == 0 ? (double)(in[i] - min_data) / ampl : 2.0 * ((double)(in[i] - min_data) / ampl) - 1.0;
-            }
+            calculate_min_max_scale(in, out, min_data, ampl, type);
         } else {
             std::fill(out.begin(), out.end(),0);
         }
@@ -113,7 +162,7 @@ namespace xtechnical_normalization {
         using NumType = typename T1::value_type;
         auto mean = std::accumulate(in.begin(), in.end(), NumType(0));
         mean /= (NumType)input_size;
-        auto diff = 0;
+        NumType diff = 0;
         for(size_t k = 0; k < input_size; ++k) {
             diff += ((in[k] - mean) * (in[k] - mean));
         }
@@ -216,6 +265,707 @@ namespace xtechnical_normalization {
         return OK;
     }
 
+    /** \brief Автоматическая регулировка усиления массива данных
+     *
+     * Дает тот же результат, что и calc_automatic_gain_control, но хранит
+     * фильтр и результаты между вызовами. Если выход фильтра зависит только
+     * от depth последних значений (например, SMA), то при сдвиге массива на
+     * один элемент пересчитываются только значения, зависящие от нового
+     * элемента. Для фильтров с бесконечной памятью (например, ФНЧ) укажите
+     * depth = 0, тогда массив пересчитывается полностью, но без выделения памяти
+     */
+    template<class T, class FILTER_TYPE>
+    class AutomaticGainControl {
+    private:
+        FILTER_TYPE filter_;
+        std::vector<T> data_;   /**< результаты прошлого вызова, начало в offset_ */
+        size_t period_ = 0;
+        size_t depth_ = 0;
+        size_t offset_ = 0;
+        bool is_looped_ = true;
+        bool is_init_ = false;
+
+        inline void calc(const T in, T &out) {
+            T temp = 0;
+            filter_.update(in, temp);
+            out = in/temp;
+        }
+
+        inline T &at(const size_t index) {
+            const size_t pos = offset_ + index;
+            return data_[pos < data_.size() ? pos : pos - data_.size()];
+        }
+
+    public:
+        AutomaticGainControl() {};
+
+        /** \brief Инициализировать регулировку усиления
+         * \param period период фильтра
+         * \param is_looped использовать зацикленный сигнал
+         * \param depth число последних значений, от которых зависит выход фильтра (0 - все)
+         */
+        AutomaticGainControl(const size_t &period, const bool &is_looped = true, const size_t &depth = 0) :
+            filter_(period), period_(period), depth_(depth), is_looped_(is_looped) {}
+
+        /** \brief Обработать массив данных
+         * \param in входные данные
+         * \param out обработанные данные, размер равен in
+         * \param is_shift массив in равен массиву прошлого вызова, сдвинутому на
+         * один элемент, с новым элементом в конце. Укажите false при разрыве данных,
+         * тогда массив будет пересчитан полностью
+         * \return вернет 0 в случае успеха, иначе см. xtechnical_common.hpp
+         */
+        template<class T1, class T2>
+        int update(const T1 &in, T2 &out, const bool is_shift = true) {
+            if(period_ == 0) return NO_INIT;
+            const size_t input_size = in.size();
+            if(input_size == 0 || out.size() != input_size || period_ > input_size) return INVALID_PARAMETER;
+            filter_.clear();
+            if(!is_shift || !is_init_ || depth_ == 0 || data_.size() != input_size ||
+                input_size < 2 * depth_) {
+                data_.resize(input_size);
+                offset_ = 0;
+                if(is_looped_) {
+                    for(size_t i = input_size - period_; i < input_size; ++i) {
+                        filter_.update(in[i]);
+                    }
+                }
+                for(size_t i = 0; i < input_size; ++i) {
+                    calc(in[i], data_[i]);
+                }
+            } else {
+                offset_ = offset_ + 1 < input_size ? offset_ + 1 : 0;
+                /* значения в начале массива зависят от его конца или от самого начала */
+                if(is_looped_) {
+                    for(size_t i = input_size - period_; i < input_size; ++i) {
+                        filter_.update(in[i]);
+                    }
+                }
+                for(size_t i = 0; i + 1 < depth_; ++i) {
+                    calc(in[i], at(i));
+                }
+                /* последнее значение зависит только от окна depth */
+                filter_.clear();
+                for(size_t i = input_size - depth_; i < input_size - 1; ++i) {
+                    filter_.update(in[i]);
+                }
+                calc(in[input_size - 1], at(input_size - 1));
+            }
+            is_init_ = true;
+            std::copy(data_.begin() + offset_, data_.end(), out.begin());
+            std::copy(data_.begin(), data_.begin() + offset_, out.begin() + (input_size - offset_));
+            return OK;
+        }
+
+        /** \brief Очистить данные регулировки усиления
+         */
+        void clear() {
+            is_init_ = false;
+            offset_ = 0;
+            filter_.clear();
+        }
+    };
+
+    /** \brief Конвейер преобразований данных
+     *
+     * Последовательность шагов (логарифм, разность, масштаб, ограничение,
+     * Z-Score, нормализация амплитуды, MinMax) выполняется блоками, которые
+     * помещаются в кэш: каждый шаг - простой векторизуемый цикл по блоку.
+     * Поэлементные шаги не требуют отдельных проходов по памяти, проход
+     * добавляет только шаг, которому нужна статистика всех данных (Z-Score,
+     * амплитуда, MinMax): статистика собирается в том же проходе, а сама
+     * нормализация выполняется в следующем вместе с последующими шагами.
+     * Например, log -> difference -> zscore -> clip занимает два прохода.
+     * Выходной массив выделяется заранее, in и out могут совпадать
+     */
+    template<class T>
+    class TransformPipeline {
+    public:
+
+        /// Типы шагов конвейера
+        enum {
+            STEP_LOG = 0,           ///< Логарифм, см. calculate_log
+            STEP_DIFFERENCE = 1,    ///< Разность соседних элементов, см. calculate_difference (размер уменьшается на 1)
+            STEP_SCALE = 2,         ///< Линейное преобразование gain * x + offset
+            STEP_CLIP = 3,          ///< Ограничение значений промежутком
+            STEP_ZSCORE = 4,        ///< Z-Score нормализация (без ограничения, для него добавьте STEP_CLIP)
+            STEP_AMPLITUDE = 5,     ///< Нормализация амплитуды, см. normalize_amplitudes
+            STEP_MIN_MAX = 6,       ///< MinMax нормализация, см. calculate_min_max
+        };
+
+    private:
+        enum {
+            BLOCK_SIZE = 256,
+        };
+
+        /// Шаг конвейера
+        class Step {
+        public:
+            int type = STEP_SCALE;
+            T param_1 = 0;
+            T param_2 = 0;
+            /* состояние шага на время прохода */
+            T prev = 0;
+            bool has_prev = false;
+            /* нормализация, найденная по статистике: (x - center) * gain + offset */
+            T center = 0;
+            T gain = 1;
+            T offset = 0;
+
+            Step() {};
+            Step(const int t, const T p1 = 0, const T p2 = 0) : type(t), param_1(p1), param_2(p2) {};
+
+            inline bool is_reduction() const {
+                return type == STEP_ZSCORE || type == STEP_AMPLITUDE || type == STEP_MIN_MAX;
+            }
+        };
+
+        /// Статистика данных для шага нормализации
+        class Stats {
+        public:
+            size_t count = 0;
+            T shift = 0;
+            T sum = 0;
+            T sum_sq = 0;
+            T min = 0;
+            T max = 0;
+        };
+
+        std::vector<Step> steps_;
+        std::vector<T> block_;
+
+        /** \brief Выполнить поэлементный шаг над блоком
+         * \param step шаг
+         * \param data блок
+         * \param begin начало данных в блоке (шаг разности может отбросить первый элемент)
+         * \param len конец данных в блоке
+         */
+        static void apply_step(Step &step, T *data, size_t &begin, const size_t len) {
+            if(begin >= len) return;
+            switch(step.type) {
+            case STEP_LOG:
+                for(size_t i = begin; i < len; ++i) data[i] = std::log(data[i]);
+                break;
+            case STEP_DIFFERENCE: {
+                    const T last = data[len - 1];
+                    for(size_t i = len - 1; i > begin; --i) data[i] -= data[i - 1];
+                    if(step.has_prev) data[begin] -= step.prev;
+                    else ++begin;
+                    step.prev = last;
+                    step.has_prev = true;
+                }
+                break;
+            case STEP_SCALE: {
+                    const T gain = step.param_1;
+                    const T offset = step.param_2;
+                    for(size_t i = begin; i < len; ++i) data[i] = data[i] * gain + offset;
+                }
+                break;
+            case STEP_CLIP: {
+                    const T min_value = step.param_1;
+                    const T max_value = step.param_2;
+                    for(size_t i = begin; i < len; ++i) {
+                        const T value = data[i] < min_value ? min_value : data[i];
+                        data[i] = value > max_value ? max_value : value;
+                    }
+                }
+                break;
+            default: {
+                    /* нормализация по статистике предыдущего прохода */
+                    const T center = step.center;
+                    const T gain = step.gain;
+                    const T offset = step.offset;
+                    for(size_t i = begin; i < len; ++i) data[i] = (data[i] - center) * gain + offset;
+                }
+                break;
+            }
+        }
+
+        static void accumulate(Stats &stats, const T *data, const size_t begin, const size_t len) {
+            if(begin >= len) return;
+            if(stats.count == 0) {
+                stats.shift = data[begin];
+                stats.min = stats.max = data[begin];
+            }
+            const T shift = stats.shift;
+            T sum = 0, sum_sq = 0, min_value = stats.min, max_value = stats.max;
+            for(size_t i = begin; i < len; ++i) {
+                const T value = data[i];
+                const T d = value - shift;
+                sum += d;
+                sum_sq += d * d;
+                min_value = value < min_value ? value : min_value;
+                max_value = value > max_value ? value : max_value;
+            }
+            stats.sum += sum;
+            stats.sum_sq += sum_sq;
+            stats.min = min_value;
+            stats.max = max_value;
+            stats.count += len - begin;
+        }
+
+        /** \brief Найти параметры нормализации по статистике
+         */
+        static void finalize(Step &step, const Stats &stats) {
+            step.center = 0;
+            step.gain = 1;
+            step.offset = 0;
+            if(step.type == STEP_ZSCORE) {
+                const T n = (T)stats.count;
+                step.center = stats.count > 0 ? stats.shift + stats.sum / n : 0;
+                const T m2 = stats.count > 0 ? stats.sum_sq - stats.sum * stats.sum / n : 0;
+                const T std_dev = stats.count > 1 && m2 > 0 ? std::sqrt(m2 / (n - 1)) : 0;
+                const T dix = step.param_1 * std_dev;
+                step.gain = dix != 0 ? 1 / dix : 0;
+            } else
+            if(step.type == STEP_AMPLITUDE) {
+                const T max_data_ampl = std::max(std::abs(stats.min), std::abs(stats.max));
+                if(max_data_ampl != 0) step.gain = step.param_1 / max_data_ampl;
+            } else
+            if(step.type == STEP_MIN_MAX) {
+                const T ampl = stats.max - stats.min;
+                if(ampl != 0) {
+                    step.center = stats.min;
+                    step.gain = (step.param_1 == 0 ? 1 : 2) / ampl;
+                    step.offset = step.param_1 == 0 ? 0 : -1;
+                } else {
+                    step.gain = 0;
+                }
+            }
+        }
+
+    public:
+
+        TransformPipeline() : block_((size_t)BLOCK_SIZE) {};
+
+        /** \brief Добавить логарифм
+         * \return конвейер
+         */
+        TransformPipeline &add_log() {
+            steps_.push_back(Step(STEP_LOG));
+            return *this;
+        }
+
+        /** \brief Добавить разность соседних элементов
+         * \return конвейер
+         */
+        TransformPipeline &add_difference() {
+            steps_.push_back(Step(STEP_DIFFERENCE));
+            return *this;
+        }
+
+        /** \brief Добавить линейное преобразование gain * x + offset
+         * \param gain множитель
+         * \param offset смещение
+         * \return конвейер
+         */
+        TransformPipeline &add_scale(const T gain, const T offset = 0) {
+            steps_.push_back(Step(STEP_SCALE, gain, offset));
+            return *this;
+        }
+
+        /** \brief Добавить ограничение значений
+         * \param min_value минимальное значение
+         * \param max_value максимальное значение
+         * \return конвейер
+         */
+        TransformPipeline &add_clip(const T min_value = -1, const T max_value = 1) {
+            steps_.push_back(Step(STEP_CLIP, min_value, max_value));
+            return *this;
+        }
+
+        /** \brief Добавить Z-Score нормализацию
+         * \param d множитель для стандартного отклонения
+         * \return конвейер
+         */
+        TransformPipeline &add_zscore(const T d = 1.0) {
+            steps_.push_back(Step(STEP_ZSCORE, d));
+            return *this;
+        }
+
+        /** \brief Добавить нормализацию амплитуды
+         * \param max_amplitude максимальная амплитуда
+         * \return конвейер
+         */
+        TransformPipeline &add_amplitude(const T max_amplitude) {
+            steps_.push_back(Step(STEP_AMPLITUDE, max_amplitude));
+            return *this;
+        }
+
+        /** \brief Добавить MinMax нормализацию
+         * \param type тип нормализации (MINMAX_UNSIGNED или MINMAX_SIGNED)
+         * \return конвейер
+         */
+        TransformPipeline &add_min_max(const int type = MINMAX_UNSIGNED) {
+            steps_.push_back(Step(STEP_MIN_MAX, type == 0 ? 0 : 1));
+            return *this;
+        }
+
+        /** \brief Выполнить преобразования
+         * \param in входные данные
+         * \param size размер входных данных
+         * \param out выходные данные, размер не меньше size (может совпадать с in)
+         * \param out_size размер выходных данных
+         * \return вернет 0 в случае успеха, иначе см. xtechnical_common.hpp
+         */
+        int calc(const T *in, const size_t size, T *out, size_t &out_size) {
+            out_size = 0;
+            if(size == 0) return INVALID_PARAMETER;
+            const T *src = in;
+            size_t src_size = size;
+            size_t first = 0;
+            bool has_normalization = false;
+            while(true) {
+                size_t last = first;
+                while(last < steps_.size() && !steps_[last].is_reduction()) ++last;
+                for(size_t s = first; s < last; ++s) steps_[s].has_prev = false;
+                Stats stats;
+                size_t write_pos = 0;
+                for(size_t pos = 0; pos < src_size; pos += BLOCK_SIZE) {
+                    const size_t len = std::min((size_t)BLOCK_SIZE, src_size - pos);
+                    T *data = block_.data();
+                    std::copy(src + pos, src + pos + len, data);
+                    size_t begin = 0;
+                    if(has_normalization) apply_step(steps_[first - 1], data, begin, len);
+                    for(size_t s = first; s < last; ++s) {
+                        apply_step(steps_[s], data, begin, len);
+                    }
+                    if(last < steps_.size()) accumulate(stats, data, begin, len);
+                    std::copy(data + begin, data + len, out + write_pos);
+                    write_pos += len - begin;
+                }
+                if(last >= steps_.size()) {
+                    out_size = write_pos;
+                    return OK;
+                }
+                finalize(steps_[last], stats);
+                src = out;
+                src_size = write_pos;
+                first = last + 1;
+                has_normalization = true;
+            }
+        }
+
+        /** \brief Выполнить преобразования
+         * \param in входные данные
+         * \param out выходные данные, размер не меньше размера in
+         * \param out_size количество полученных значений
+         * \return вернет 0 в случае успеха, иначе см. xtechnical_common.hpp
+         */
+        template<class T1, class T2>
+        int calc(const T1 &in, T2 &out, size_t &out_size) {
+            out_size = 0;
+            if(out.size() < in.size()) return INVALID_PARAMETER;
+            return calc(in.data(), in.size(), out.data(), out_size);
+        }
+
+        /** \brief Удалить все шаги
+         */
+        void clear() {
+            steps_.clear();
+        }
+    };
+
+    /** \brief Скользящая MinMax нормализация
+     *
+     * Минимум и максимум окна поддерживаются монотонными очередями,
+     * поэтому нормализованное значение нового элемента считается за O(1)
+     * (амортизированно). Результат совпадает с calculate_min_max по окну
+     */
+    template<class T>
+    class RollingMinMax {
+    private:
+        std::vector<T> buffer_;
+        std::deque<std::pair<size_t, T>> min_queue_;  ///< Номер и значение, значения возрастают
+        std::deque<std::pair<size_t, T>> max_queue_;  ///< Номер и значение, значения убывают
+        size_t period_ = 0;
+        size_t counter_ = 0;
+        int type_ = MINMAX_UNSIGNED;
+
+        inline T normalize(const T value, const T min_data, const T max_data) const {
+            const T ampl = max_data - min_data;
+            if(ampl == 0) return 0;
+            return type_ == 0 ? (value - min_data) / ampl : 2.0 * ((value - min_data) / ampl) - 1.0;
+        }
+
+        /** \brief Найти экстремум окна без самого старого элемента
+         * \return вернет false, если в окне без старого элемента нет значений
+         */
+        inline bool get_rest(const std::deque<std::pair<size_t, T>> &queue, const size_t oldest, T &value) const {
+            if(queue.empty()) return false;
+            if(queue.front().first != oldest) {
+                value = queue.front().second;
+                return true;
+            }
+            if(queue.size() < 2) return false;
+            value = queue[1].second;
+            return true;
+        }
+
+    public:
+
+        RollingMinMax() {};
+
+        /** \brief Инициализировать скользящую MinMax нормализацию
+         * \param period период
+         * \param type тип нормализации (MINMAX_UNSIGNED или MINMAX_SIGNED)
+         */
+        RollingMinMax(const size_t period, const int type = MINMAX_UNSIGNED) :
+            buffer_(period), period_(period), type_(type) {
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигнал на входе
+         * \param out нормализованное значение сигнала на входе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T in, T &out) {
+            out = 0;
+            if(period_ == 0) return NO_INIT;
+            buffer_[counter_ % period_] = in;
+            while(!min_queue_.empty() && min_queue_.back().second >= in) min_queue_.pop_back();
+            min_queue_.push_back(std::make_pair(counter_, in));
+            while(!max_queue_.empty() && max_queue_.back().second <= in) max_queue_.pop_back();
+            max_queue_.push_back(std::make_pair(counter_, in));
+            ++counter_;
+            if(min_queue_.front().first + period_ < counter_) min_queue_.pop_front();
+            if(max_queue_.front().first + period_ < counter_) max_queue_.pop_front();
+            if(counter_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+            out = normalize(in, min_queue_.front().second, max_queue_.front().second);
+            return OK;
+        }
+
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем,
+         * что не влияет на внутреннее состояние индикатора
+         * \param in сигнал на входе
+         * \param out нормализованное значение сигнала на входе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int test(const T in, T &out) const {
+            out = 0;
+            if(period_ == 0) return NO_INIT;
+            if(counter_ + 1 < period_) return INDICATOR_NOT_READY_TO_WORK;
+            /* при заполненном окне самый старый элемент будет вытеснен */
+            const size_t oldest = counter_ >= period_ ? counter_ - period_ : counter_;
+            T min_data = in, max_data = in, value = 0;
+            if(get_rest(min_queue_, oldest, value)) min_data = std::min(min_data, value);
+            if(get_rest(max_queue_, oldest, value)) max_data = std::max(max_data, value);
+            out = normalize(in, min_data, max_data);
+            return OK;
+        }
+
+        /** \brief Получить нормализованное окно
+         *
+         * Окно нормализуется только по запросу, за O(period)
+         * \param out нормализованные значения окна от старого к новому
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template<class T2>
+        int get_normalized_window(T2 &out) const {
+            if(period_ == 0) return NO_INIT;
+            if(counter_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+            out.resize(period_);
+            const T min_data = min_queue_.front().second;
+            const T max_data = max_queue_.front().second;
+            for(size_t i = 0; i < period_; ++i) {
+                out[i] = normalize(buffer_[(counter_ + i) % period_], min_data, max_data);
+            }
+            return OK;
+        }
+
+        /** \brief Получить минимальное значение окна
+         * \return минимальное значение
+         */
+        inline T get_min() const {
+            return min_queue_.empty() ? 0 : min_queue_.front().second;
+        }
+
+        /** \brief Получить максимальное значение окна
+         * \return максимальное значение
+         */
+        inline T get_max() const {
+            return max_queue_.empty() ? 0 : max_queue_.front().second;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            std::fill(buffer_.begin(), buffer_.end(), T(0));
+            min_queue_.clear();
+            max_queue_.clear();
+            counter_ = 0;
+        }
+    };
+
+    /** \brief Скользящая Z-Score нормализация
+     *
+     * Среднее и дисперсия окна обновляются за O(1) при сдвиге окна
+     * и пересчитываются заново раз в period тиков. Если сумма квадратов
+     * отклонений не больше накопленной ошибки округления (например,
+     * постоянное окно), дисперсия считается нулевой без пересчета.
+     * Результат совпадает с calculate_zscore по окну с точностью
+     * до округления (включая ограничение значений промежутком от -1 до 1)
+     */
+    template<class T>
+    class RollingZScore {
+    private:
+        std::vector<T> buffer_;
+        T mean_ = 0;
+        T m2_ = 0;
+        T m2_error_ = 0;
+        T d_ = 1.0;
+        size_t period_ = 0;
+        size_t counter_ = 0;
+        size_t updates_since_recalc_ = 0;
+
+        /** \brief Посчитать среднее и сумму квадратов отклонений по окну
+         * \param replace_pos позиция в буфере, значение которой заменяется на value
+         * \param value новое значение для позиции replace_pos
+         */
+        void calc_exact(const size_t replace_pos, const T value, T &mean, T &m2) const {
+            T sum = 0;
+            for(size_t i = 0; i < period_; ++i) {
+                sum += i == replace_pos ? value : buffer_[i];
+            }
+            mean = sum / (T)period_;
+            m2 = 0;
+            for(size_t i = 0; i < period_; ++i) {
+                const T diff = (i == replace_pos ? value : buffer_[i]) - mean;
+                m2 += diff * diff;
+            }
+        }
+
+        /** \brief Нормализовать значение
+         * \param m2_error оценка ошибки округления m2, m2 не больше нее считается нулем
+         */
+        inline T normalize(const T value, const T mean, const T m2, const T m2_error) const {
+            if(m2 <= m2_error) return 0;
+            const T std_dev = m2 > 0 && period_ > 1 ? std::sqrt(m2 / (T)(period_ - 1)) : 0;
+            const T dix = d_ * std_dev;
+            if(dix == 0) return 0;
+            const T z = (value - mean) / dix;
+            return std::min(std::max(z, T(-1)), T(1));
+        }
+
+        /** \brief Сдвинуть окно: заменить old_value на in
+         *
+         * Вместе с суммой квадратов отклонений накапливается оценка ошибки округления
+         */
+        inline void shift(const T old_value, const T in, T &mean, T &m2, T &m2_error) const {
+            const T mean_prev = mean;
+            const T delta = in - old_value;
+            mean += delta / (T)period_;
+            const T term = delta * (in - mean + old_value - mean_prev);
+            m2 += term;
+            m2_error += 4 * std::numeric_limits<T>::epsilon() *
+                (std::abs(m2) + std::abs(term) + 2 * std::abs(delta) * std::abs(mean));
+        }
+
+    public:
+
+        RollingZScore() {};
+
+        /** \brief Инициализировать скользящую Z-Score нормализацию
+         * \param period период
+         * \param d множитель для стандартного отклонения
+         */
+        RollingZScore(const size_t period, const T d = 1.0) :
+            buffer_(period), d_(d), period_(period) {
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигнал на входе
+         * \param out нормализованное значение сигнала на входе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T in, T &out) {
+            out = 0;
+            if(period_ == 0) return NO_INIT;
+            const size_t pos = counter_ % period_;
+            const T old_value = buffer_[pos];
+            buffer_[pos] = in;
+            ++counter_;
+            if(counter_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+            if(counter_ == period_ || ++updates_since_recalc_ >= period_) {
+                calc_exact(period_, 0, mean_, m2_);
+                m2_error_ = 0;
+                updates_since_recalc_ = 0;
+            } else {
+                shift(old_value, in, mean_, m2_, m2_error_);
+            }
+            out = normalize(in, mean_, m2_, m2_error_);
+            return OK;
+        }
+
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем,
+         * что не влияет на внутреннее состояние индикатора
+         * \param in сигнал на входе
+         * \param out нормализованное значение сигнала на входе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int test(const T in, T &out) const {
+            out = 0;
+            if(period_ == 0) return NO_INIT;
+            if(counter_ + 1 < period_) return INDICATOR_NOT_READY_TO_WORK;
+            const size_t pos = counter_ % period_;
+            T mean = mean_, m2 = m2_, m2_error = m2_error_;
+            if(counter_ < period_) {
+                calc_exact(pos, in, mean, m2);
+                m2_error = 0;
+            } else {
+                shift(buffer_[pos], in, mean, m2, m2_error);
+            }
+            out = normalize(in, mean, m2, m2_error);
+            return OK;
+        }
+
+        /** \brief Получить нормализованное окно
+         *
+         * Окно нормализуется только по запросу, за O(period)
+         * \param out нормализованные значения окна от старого к новому
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template<class T2>
+        int get_normalized_window(T2 &out) const {
+            if(period_ == 0) return NO_INIT;
+            if(counter_ < period_) return INDICATOR_NOT_READY_TO_WORK;
+            out.resize(period_);
+            for(size_t i = 0; i < period_; ++i) {
+                out[i] = normalize(buffer_[(counter_ + i) % period_], mean_, m2_, m2_error_);
+            }
+            return OK;
+        }
+
+        /** \brief Получить среднее значение окна
+         * \return среднее значение
+         */
+        inline T get_mean() const {
+            return mean_;
+        }
+
+        /** \brief Получить стандартное отклонение окна
+         * \return стандартное отклонение выборки
+         */
+        inline T get_std_dev() const {
+            return period_ > 1 && m2_ > m2_error_ ? std::sqrt(m2_ / (T)(period_ - 1)) : 0;
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            std::fill(buffer_.begin(), buffer_.end(), T(0));
+            mean_ = 0;
+            m2_ = 0;
+            m2_error_ = 0;
+            counter_ = 0;
+            updates_since_recalc_ = 0;
+        }
+    };
+
 }
 
 #endif // NORMALIZATIONEASY_HPP_INCLUDED
@@ -0,0 +1,345 @@
+/*
+* xtechnical_analysis - Technical analysis C++ library
+*
+* Copyright (c) 2018 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef XTECHNICAL_QUANTILE_SKETCH_HPP_INCLUDED
+#define XTECHNICAL_QUANTILE_SKETCH_HPP_INCLUDED
+
+#include "xtechnical_common.hpp"
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+#include <limits>
+
+namespace xtechnical_statistics {
+
+    /** \brief Поток квантилей (t-digest)
+     *
+     * Хранит распределение в виде ограниченного числа центроидов (среднее и вес).
+     * Размер центроидов ограничен функцией масштаба k(q) = compression / (2 pi) * asin(2q - 1),
+     * поэтому на хвостах (p1, p99) центроиды мелкие и точность выше, чем в центре.
+     * Память ограничена примерно compression * pi / 2 центроидами и буфером
+     * новых значений. Дайджесты, посчитанные по частям данных, можно объединять
+     */
+    template<class T>
+    class TDigest {
+    public:
+
+        /** \brief Центроид
+         */
+        class Centroid {
+        public:
+            T mean = 0;
+            T weight = 0;
+
+            Centroid() {};
+
+            Centroid(const T m, const T w) : mean(m), weight(w) {};
+
+            inline bool operator < (const Centroid &other) const {
+                return mean < other.mean;
+            }
+        };
+
+    private:
+        std::vector<Centroid> centroids_;
+        std::vector<Centroid> buffer_;
+        std::vector<Centroid> temp_;
+        T compression_ = 100;
+        T total_weight_ = 0;
+        T min_ = std::numeric_limits<T>::max();
+        T max_ = std::numeric_limits<T>::lowest();
+        size_t buffer_limit_ = 0;
+
+        static const uint32_t SERIALIZATION_ID = 0x54444731; // "TDG1"
+
+        /// Допустимый параметр сжатия: от MIN_COMPRESSION до MAX_COMPRESSION
+        static constexpr double MIN_COMPRESSION = 10.0;
+        static constexpr double MAX_COMPRESSION = 1.0e6;
+
+        /** \brief Ограничить параметр сжатия допустимым диапазоном (NaN - минимум)
+         */
+        static T clamp_compression(const T compression) {
+            if(!(compression >= (T)MIN_COMPRESSION)) return (T)MIN_COMPRESSION;
+            if(!(compression <= (T)MAX_COMPRESSION)) return (T)MAX_COMPRESSION;
+            return compression;
+        }
+
+        inline T calc_k(const T q) const {
+            const T pi = 3.14159265358979323846;
+            return compression_ / (2.0 * pi) * std::asin(2.0 * q - 1.0);
+        }
+
+        inline T calc_q(const T k) const {
+            const T pi = 3.14159265358979323846;
+            const T angle = std::min(std::max(k * 2.0 * pi / compression_, -pi / 2.0), pi / 2.0);
+            return (std::sin(angle) + 1.0) / 2.0;
+        }
+
+        inline T calc_q_limit(const T weight_so_far) const {
+            return calc_q(calc_k(weight_so_far / total_weight_) + 1.0);
+        }
+
+        /** \brief Слить буфер с центроидами
+         */
+        void compress() {
+            if(buffer_.empty()) return;
+            temp_.swap(buffer_);
+            temp_.insert(temp_.end(), centroids_.begin(), centroids_.end());
+            buffer_.clear();
+            centroids_.clear();
+            std::sort(temp_.begin(), temp_.end());
+
+            total_weight_ = 0;
+            for(size_t i = 0; i < temp_.size(); ++i) {
+                total_weight_ += temp_[i].weight;
+            }
+
+            Centroid current = temp_[0];
+            T weight_so_far = 0;
+            T q_limit = calc_q_limit(weight_so_far);
+            for(size_t i = 1; i < temp_.size(); ++i) {
+                const Centroid &next = temp_[i];
+                const T proposed_weight = current.weight + next.weight;
+                if((weight_so_far + proposed_weight) / total_weight_ <= q_limit) {
+                    current.mean += (next.mean - current.mean) * next.weight / proposed_weight;
+                    current.weight = proposed_weight;
+                } else {
+                    weight_so_far += current.weight;
+                    centroids_.push_back(current);
+                    q_limit = calc_q_limit(weight_so_far);
+                    current = next;
+                }
+            }
+            centroids_.push_back(current);
+            temp_.clear();
+        }
+
+        template<class T2>
+        static void write_value(std::string &data, const T2 value) {
+            data.append(reinterpret_cast<const char*>(&value), sizeof(T2));
+        }
+
+        template<class T2>
+        static bool read_value(const std::string &data, size_t &offset, T2 &value) {
+            if(offset + sizeof(T2) > data.size()) return false;
+            std::memcpy(&value, data.data() + offset, sizeof(T2));
+            offset += sizeof(T2);
+            return true;
+        }
+
+    public:
+
+        TDigest() : buffer_limit_(500) {};
+
+        /** \brief Инициализировать поток квантилей
+         * \param compression Параметр сжатия. Чем больше, тем выше точность и больше память.
+         * Относительная ошибка квантиля порядка 1 / compression, на хвостах меньше.
+         * Ограничивается диапазоном от 10 до 1e6
+         */
+        TDigest(const T compression) :
+            compression_(clamp_compression(compression)),
+            buffer_limit_((size_t)(5 * compression_)) {
+        }
+
+        /** \brief Добавить значение
+         * \param value Значение
+         * \param weight Вес значения
+         */
+        void add(const T value, const T weight = 1) {
+            if(weight <= 0 || value != value) return;
+            buffer_.push_back(Centroid(value, weight));
+            min_ = std::min(min_, value);
+            max_ = std::max(max_, value);
+            if(buffer_.size() >= buffer_limit_) compress();
+        }
+
+        /** \brief Объединить с другим потоком квантилей
+         *
+         * Объединение с самим собой удваивает веса всех значений
+         * \param other Поток квантилей
+         */
+        void merge(const TDigest<T> &other) {
+            if(other.centroids_.empty() && other.buffer_.empty()) return;
+            if(&other == this) {
+                const TDigest<T> copy(other);
+                merge(copy);
+                return;
+            }
+            buffer_.insert(buffer_.end(), other.centroids_.begin(), other.centroids_.end());
+            buffer_.insert(buffer_.end(), other.buffer_.begin(), other.buffer_.end());
+            min_ = std::min(min_, other.min_);
+            max_ = std::max(max_, other.max_);
+            compress();
+        }
+
+        /** \brief Получить значение квантиля
+         * \param quantile Уровень квантиля от 0 до 1
+         * \return значение квантиля или 0, если данных нет
+         */
+        T get_quantile(const T quantile) {
+            compress();
+            if(centroids_.empty()) return (T)0;
+            const T q = std::min(std::max(quantile, (T)0), (T)1);
+            if(centroids_.size() == 1) {
+                if(q == 0) return min_;
+                if(q == 1) return max_;
+                return centroids_[0].mean;
+            }
+            const T index = q * total_weight_;
+            const Centroid &first = centroids_.front();
+            const Centroid &last = centroids_.back();
+            const T first_half = first.weight / 2.0;
+            const T last_half = last.weight / 2.0;
+
+            /* левый хвост: между минимумом и центром первого центроида */
+            if(index < first_half) {
+                return min_ + (first.mean - min_) * index / first_half;
+            }
+            /* правый хвост: между центром последнего центроида и максимумом */
+            if(index >= total_weight_ - last_half) {
+                const T z = (total_weight_ - index) / last_half;
+                return max_ - (max_ - last.mean) * z;
+            }
+            T weight_so_far = first_half;
+            for(size_t i = 0; i + 1 < centroids_.size(); ++i) {
+                const T dw = (centroids_[i].weight + centroids_[i + 1].weight) / 2.0;
+                if(weight_so_far + dw > index) {
+                    const T z1 = index - weight_so_far;
+                    const T z2 = weight_so_far + dw - index;
+                    return (centroids_[i].mean * z2 + centroids_[i + 1].mean * z1) / dw;
+                }
+                weight_so_far += dw;
+            }
+            return last.mean;
+        }
+
+        /** \brief Получить суммарный вес (количество значений)
+         * \return суммарный вес
+         */
+        T get_count() {
+            compress();
+            return total_weight_;
+        }
+
+        /** \brief Получить минимальное значение
+         * \return минимальное значение или 0, если данных нет
+         */
+        inline T get_min() const {
+            if(centroids_.empty() && buffer_.empty()) return (T)0;
+            return min_;
+        }
+
+        /** \brief Получить максимальное значение
+         * \return максимальное значение или 0, если данных нет
+         */
+        inline T get_max() const {
+            if(centroids_.empty() && buffer_.empty()) return (T)0;
+            return max_;
+        }
+
+        /** \brief Получить количество центроидов
+         * \return количество центроидов
+         */
+        size_t get_num_centroids() {
+            compress();
+            return centroids_.size();
+        }
+
+        /** \brief Сохранить поток квантилей в бинарную строку
+         *
+         * Значения сохраняются как double в порядке байт платформы
+         * \param data Бинарная строка
+         */
+        void serialize(std::string &data) {
+            compress();
+            data.clear();
+            data.reserve(sizeof(uint32_t) + sizeof(uint64_t) + 3 * sizeof(double) +
+                2 * sizeof(double) * centroids_.size());
+            write_value<uint32_t>(data, SERIALIZATION_ID);
+            write_value<double>(data, (double)compression_);
+            write_value<double>(data, (double)min_);
+            write_value<double>(data, (double)max_);
+            write_value<uint64_t>(data, (uint64_t)centroids_.size());
+            for(size_t i = 0; i < centroids_.size(); ++i) {
+                write_value<double>(data, (double)centroids_[i].mean);
+                write_value<double>(data, (double)centroids_[i].weight);
+            }
+        }
+
+        /** \brief Загрузить поток квантилей из бинарной строки
+         * \param data Бинарная строка, полученная от serialize
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int deserialize(const std::string &data) {
+            size_t offset = 0;
+            uint32_t id = 0;
+            double compression = 0, min_value = 0, max_value = 0;
+            uint64_t size = 0;
+            if(!read_value(data, offset, id) || id != SERIALIZATION_ID ||
+                !read_value(data, offset, compression) ||
+                !(compression >= MIN_COMPRESSION && compression <= MAX_COMPRESSION) ||
+                !read_value(data, offset, min_value) || !std::isfinite(min_value) ||
+                !read_value(data, offset, max_value) || !std::isfinite(max_value) ||
+                !read_value(data, offset, size) ||
+                size > (data.size() - offset) / (2 * sizeof(double)) ||
+                (data.size() - offset) != size * 2 * sizeof(double)) {
+                return xtechnical_common::INVALID_PARAMETER;
+            }
+            std::vector<Centroid> centroids((size_t)size);
+            T total_weight = 0;
+            for(size_t i = 0; i < centroids.size(); ++i) {
+                double mean = 0, weight = 0;
+                read_value(data, offset, mean);
+                read_value(data, offset, weight);
+                if(!std::isfinite(mean) || !(weight > 0) || !std::isfinite(weight)) {
+                    return xtechnical_common::INVALID_PARAMETER;
+                }
+                centroids[i] = Centroid((T)mean, (T)weight);
+                total_weight += (T)weight;
+            }
+            compression_ = (T)compression;
+            buffer_limit_ = (size_t)(5 * compression_);
+            min_ = (T)min_value;
+            max_ = (T)max_value;
+            centroids_.swap(centroids);
+            buffer_.clear();
+            total_weight_ = total_weight;
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Очистить данные
+         */
+        void clear() {
+            centroids_.clear();
+            buffer_.clear();
+            total_weight_ = 0;
+            min_ = std::numeric_limits<T>::max();
+            max_ = std::numeric_limits<T>::lowest();
+        }
+    };
+}
+
+#endif // XTECHNICAL_QUANTILE_SKETCH_HPP_INCLUDED
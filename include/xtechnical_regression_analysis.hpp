@@ -1,6 +1,14 @@
 #ifndef XTECHNICAL_REGRESSION_ANALYSIS_HPP_INCLUDED
 #define XTECHNICAL_REGRESSION_ANALYSIS_HPP_INCLUDED
 
+#include "xtechnical_common.hpp"
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstddef>
+
 namespace xtechnical_regression_analysis {
 
     enum LeastSquaresMethodType {
@@ -29,7 +37,7 @@ namespace xtechnical_regression_analysis {
             }
             //coeff.resize(2);
             coeff[1] = ((double)size_point * sxy - (sx * sy)) / ((double)size_point * sx2 - sx * sx);
-            coeff[0] = (sy - coeff[0] * sx) / (double)size_point;
+            coeff[0] = (sy - coeff[1] * sx) / (double)size_point;
         } else
         if(type == LSM_PARABOLA) {
             double sx = 0, sy = 0, sx2 = 0, sx3 = 0, sx4 = 0, sxy = 0, sx2y = 0;
@@ -97,7 +105,7 @@ namespace xtechnical_regression_analysis {
             }
             //coeff.resize(2);
             coeff[1] = ((double)array_size * sxy - (sx * sy)) / ((double)array_size * sx2 - sx * sx);
-            coeff[0] = (sy - coeff[0] * sx) / (double)array_size;
+            coeff[0] = (sy - coeff[1] * sx) / (double)array_size;
         } else
         if(type == LSM_PARABOLA) {
             double sx = 0, sy = 0, sx2 = 0, sx3 = 0, sx4 = 0, sxy = 0, sx2y = 0;
@@ -153,6 +161,680 @@ namespace xtechnical_regression_analysis {
         }
         return 0;
     }
+
+    /** \brief Решение задачи наименьших квадратов через QR-разложение
+     *
+     * Матрица плана хранится по столбцам (column-major): элемент строки i
+     * столбца j находится по индексу j * rows + i, поэтому отражения Хаусхолдера
+     * проходят по непрерывной памяти. Разложение выполняется один раз в init,
+     * после чего можно решать задачу для любого числа векторов y с той же
+     * матрицей плана (например, для множества окон с одинаковыми x)
+     */
+    template <typename T>
+    class LeastSquaresQR {
+    private:
+        std::vector<T> qr_;         ///< Векторы отражений под диагональю и R над диагональю
+        std::vector<T> beta_;       ///< Множители отражений 2 / (v' * v)
+        std::vector<T> r_diag_;     ///< Диагональ R
+        std::vector<T> work_;
+        size_t rows_ = 0;
+        size_t cols_ = 0;
+        bool is_init_ = false;
+
+    public:
+
+        LeastSquaresQR() {};
+
+        /** \brief Разложить матрицу плана
+         * \param design матрица плана rows x cols по столбцам
+         * \param rows количество наблюдений
+         * \param cols количество коэффициентов (не больше rows)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         * (INVALID_PARAMETER, если столбцы матрицы линейно зависимы)
+         */
+        template <typename T2>
+        int init(const std::vector<T2> &design, const size_t rows, const size_t cols) {
+            is_init_ = false;
+            if(cols == 0 || rows < cols || design.size() != rows * cols)
+                return xtechnical_common::INVALID_PARAMETER;
+            rows_ = rows;
+            cols_ = cols;
+            qr_.assign(design.begin(), design.end());
+            beta_.assign(cols, T(0));
+            r_diag_.assign(cols, T(0));
+            work_.resize(rows);
+            T max_diag = 0;
+            for(size_t k = 0; k < cols; ++k) {
+                T *v = &qr_[k * rows];
+                T norm = 0;
+                for(size_t i = k; i < rows; ++i) norm += v[i] * v[i];
+                norm = std::sqrt(norm);
+                if(norm == 0) return xtechnical_common::INVALID_PARAMETER;
+                const T alpha = v[k] > 0 ? -norm : norm;
+                v[k] -= alpha;
+                T v_norm2 = 0;
+                for(size_t i = k; i < rows; ++i) v_norm2 += v[i] * v[i];
+                beta_[k] = 2 / v_norm2;
+                r_diag_[k] = alpha;
+                for(size_t j = k + 1; j < cols; ++j) {
+                    T *a = &qr_[j * rows];
+                    T s = 0;
+                    for(size_t i = k; i < rows; ++i) s += v[i] * a[i];
+                    s *= beta_[k];
+                    for(size_t i = k; i < rows; ++i) a[i] -= s * v[i];
+                }
+                max_diag = std::max(max_diag, std::abs(alpha));
+            }
+            const T eps = std::numeric_limits<T>::epsilon() * (T)rows * max_diag;
+            for(size_t k = 0; k < cols; ++k) {
+                if(std::abs(r_diag_[k]) <= eps) return xtechnical_common::INVALID_PARAMETER;
+            }
+            is_init_ = true;
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Найти коэффициенты регрессии
+         * \param y вектор наблюдений, размер rows
+         * \param coeff коэффициенты, размер cols
+         * \param rss сумма квадратов остатков (можно не указывать)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2, typename T3>
+        int solve(const T2 *y, T3 *coeff, T *rss = NULL) {
+            if(!is_init_) return xtechnical_common::NO_INIT;
+            std::copy(y, y + rows_, work_.begin());
+            /* y = Q' * y */
+            for(size_t k = 0; k < cols_; ++k) {
+                const T *v = &qr_[k * rows_];
+                T s = 0;
+                for(size_t i = k; i < rows_; ++i) s += v[i] * work_[i];
+                s *= beta_[k];
+                for(size_t i = k; i < rows_; ++i) work_[i] -= s * v[i];
+            }
+            /* R * coeff = y */
+            for(size_t k = cols_; k-- > 0;) {
+                T s = work_[k];
+                for(size_t j = k + 1; j < cols_; ++j) s -= qr_[j * rows_ + k] * work_[j];
+                work_[k] = s / r_diag_[k];
+            }
+            for(size_t k = 0; k < cols_; ++k) coeff[k] = work_[k];
+            if(rss != NULL) {
+                T sum = 0;
+                for(size_t i = cols_; i < rows_; ++i) sum += work_[i] * work_[i];
+                *rss = sum;
+            }
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Найти коэффициенты регрессии
+         * \param y вектор наблюдений, размер rows
+         * \param coeff коэффициенты
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2, typename T3>
+        int solve(const std::vector<T2> &y, std::vector<T3> &coeff) {
+            if(!is_init_) return xtechnical_common::NO_INIT;
+            if(y.size() != rows_) return xtechnical_common::INVALID_PARAMETER;
+            coeff.resize(cols_);
+            return solve(y.data(), coeff.data());
+        }
+
+        /** \brief Найти коэффициенты регрессии для нескольких векторов наблюдений
+         * \param y векторы наблюдений по столбцам, размер rows x num_series
+         * \param num_series количество векторов наблюдений
+         * \param coeff коэффициенты по столбцам, размер cols x num_series
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2, typename T3>
+        int solve_batch(const std::vector<T2> &y, const size_t num_series, std::vector<T3> &coeff) {
+            if(!is_init_) return xtechnical_common::NO_INIT;
+            if(y.size() != rows_ * num_series) return xtechnical_common::INVALID_PARAMETER;
+            coeff.resize(cols_ * num_series);
+            for(size_t s = 0; s < num_series; ++s) {
+                solve(y.data() + s * rows_, coeff.data() + s * cols_);
+            }
+            return xtechnical_common::OK;
+        }
+
+        inline size_t get_rows() const {
+            return rows_;
+        }
+
+        inline size_t get_cols() const {
+            return cols_;
+        }
+    };
+
+    /** \brief Множественная линейная регрессия
+     * \param design матрица плана rows x cols по столбцам (для свободного члена нужен столбец единиц)
+     * \param rows количество наблюдений
+     * \param cols количество коэффициентов
+     * \param y вектор наблюдений
+     * \param coeff коэффициенты регрессии
+     * \return вернет 0 в случае успеха, иначе см. ErrorType
+     */
+    template <typename T1, typename T2>
+    int calc_linear_regression(
+            const std::vector<T1> &design,
+            const size_t rows,
+            const size_t cols,
+            const std::vector<T1> &y,
+            std::vector<T2> &coeff) {
+        LeastSquaresQR<T1> qr;
+        const int err = qr.init(design, rows, cols);
+        if(err != xtechnical_common::OK) return err;
+        return qr.solve(y, coeff);
+    }
+
+    /** \brief Посчитать значение полинома
+     * \param coeff коэффициенты A0, A1, ... Ak
+     * \param degree степень полинома
+     * \param x аргумент
+     * \return значение полинома A0 + A1*x + ... + Ak*x^k
+     */
+    template <typename T1, typename T2>
+    T2 calc_polynomial(const T1 &coeff, const size_t degree, const T2 x) {
+        T2 sum = coeff[degree];
+        for(size_t k = degree; k-- > 0;) {
+            sum = sum * x + coeff[k];
+        }
+        return sum;
+    }
+
+    /** \brief Полиномиальная регрессия степени k
+     *
+     * Перед построением матрицы Вандермонда x центрируется и масштабируется
+     * к отрезку [-1, 1], поэтому задача остается хорошо обусловленной и при
+     * больших x (например, метках времени). Матрица раскладывается один раз
+     * в init, решать можно для множества векторов y с теми же x
+     */
+    template <typename T>
+    class PolynomialRegression {
+    private:
+        LeastSquaresQR<T> qr_;
+        std::vector<T> scaled_coeff_;
+        size_t degree_ = 0;
+        T x_center_ = 0;
+        T x_scale_ = 1;
+
+        /** \brief Перевести коэффициенты из масштабированного x в исходный
+         */
+        template <typename T2>
+        void convert_coefficients(const T *scaled, T2 *coeff) const {
+            /* схема Горнера для полинома от (x - center) / scale */
+            std::vector<T> poly(degree_ + 1, T(0));
+            const T a = 1 / x_scale_;
+            const T b = -x_center_ / x_scale_;
+            for(size_t k = degree_ + 1; k-- > 0;) {
+                for(size_t j = degree_; j > 0; --j) {
+                    poly[j] = poly[j] * b + poly[j - 1] * a;
+                }
+                poly[0] = poly[0] * b + scaled[k];
+            }
+            for(size_t k = 0; k <= degree_; ++k) coeff[k] = poly[k];
+        }
+
+    public:
+
+        PolynomialRegression() {};
+
+        /** \brief Инициализировать полиномиальную регрессию
+         * \param degree степень полинома
+         */
+        PolynomialRegression(const size_t degree) : degree_(degree) {};
+
+        /** \brief Задать значения x и разложить матрицу плана
+         * \param x значения x (больше degree различных значений)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2>
+        int init(const std::vector<T2> &x) {
+            const size_t rows = x.size();
+            const size_t cols = degree_ + 1;
+            if(rows < cols) return xtechnical_common::INVALID_PARAMETER;
+            const T x_min = *std::min_element(x.begin(), x.end());
+            const T x_max = *std::max_element(x.begin(), x.end());
+            x_center_ = (x_max + x_min) / 2;
+            x_scale_ = x_max > x_min ? (x_max - x_min) / 2 : 1;
+            std::vector<T> design(rows * cols);
+            for(size_t i = 0; i < rows; ++i) {
+                const T z = ((T)x[i] - x_center_) / x_scale_;
+                T p = 1;
+                for(size_t k = 0; k < cols; ++k) {
+                    design[k * rows + i] = p;
+                    p *= z;
+                }
+            }
+            return qr_.init(design, rows, cols);
+        }
+
+        /** \brief Найти коэффициенты полинома
+         * \param y значения y, размер как у x
+         * \param coeff коэффициенты A0, A1, ... Ak для исходного x (см. calc_polynomial)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2, typename T3>
+        int solve(const std::vector<T2> &y, std::vector<T3> &coeff) {
+            const int err = qr_.solve(y, scaled_coeff_);
+            if(err != xtechnical_common::OK) return err;
+            coeff.resize(degree_ + 1);
+            convert_coefficients(scaled_coeff_.data(), coeff.data());
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Найти коэффициенты полинома для нескольких векторов y
+         * \param y векторы y по столбцам, размер x.size() x num_series
+         * \param num_series количество векторов
+         * \param coeff коэффициенты по столбцам, размер (degree + 1) x num_series
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2, typename T3>
+        int solve_batch(const std::vector<T2> &y, const size_t num_series, std::vector<T3> &coeff) {
+            const int err = qr_.solve_batch(y, num_series, scaled_coeff_);
+            if(err != xtechnical_common::OK) return err;
+            const size_t cols = degree_ + 1;
+            coeff.resize(cols * num_series);
+            for(size_t s = 0; s < num_series; ++s) {
+                convert_coefficients(scaled_coeff_.data() + s * cols, coeff.data() + s * cols);
+            }
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Получить значение полинома для последнего решения
+         *
+         * Считается в масштабированном x, что точнее, чем через коэффициенты для исходного x.
+         * После solve_batch используется полином вектора series
+         * \param x аргумент
+         * \param series номер вектора y из solve_batch (0 после solve)
+         * \return значение полинома (0, если решения для series нет)
+         */
+        T predict(const T x, const size_t series = 0) const {
+            const size_t cols = degree_ + 1;
+            if(scaled_coeff_.size() < (series + 1) * cols) return 0;
+            return calc_polynomial(scaled_coeff_.data() + series * cols, degree_, (x - x_center_) / x_scale_);
+        }
+    };
+
+    /** \brief Полиномиальная регрессия степени k
+     * \param x значения x
+     * \param y значения y
+     * \param degree степень полинома
+     * \param coeff коэффициенты A0, A1, ... Ak (см. calc_polynomial)
+     * \return вернет 0 в случае успеха, иначе см. ErrorType
+     */
+    template <typename T1, typename T2>
+    int calc_polynomial_regression(
+            const std::vector<T1> &x,
+            const std::vector<T1> &y,
+            const size_t degree,
+            std::vector<T2> &coeff) {
+        if(x.size() != y.size()) return xtechnical_common::INVALID_PARAMETER;
+        PolynomialRegression<T1> regression(degree);
+        const int err = regression.init(x);
+        if(err != xtechnical_common::OK) return err;
+        return regression.solve(y, coeff);
+    }
+
+    /** \brief Пакетный метод наименьших квадратов для множества выборок
+     *
+     * Для окна из period баров x = 0, 1, ... period - 1 одинаковы у всех выборок,
+     * поэтому матрица P = (X' * X)^-1 * X' считается один раз (через QR-разложение).
+     * Коэффициенты каждой выборки равны P * y, что для K выборок в формате SoA
+     * (значения всех выборок на одном баре лежат подряд) дает один векторизуемый
+     * проход по данным. Коэффициенты совпадают с calc_least_squares_method (см. calc_line)
+     */
+    template <typename T>
+    class BatchLeastSquares {
+    private:
+        std::vector<T> projection_;     ///< Матрица P, строка на каждый коэффициент
+        size_t period_ = 0;
+        size_t num_coeff_ = 0;
+
+    public:
+
+        BatchLeastSquares() {};
+
+        /** \brief Инициализировать пакетный метод наименьших квадратов
+         * \param period количество баров в окне
+         * \param type тип линии (LSM_LINE или LSM_PARABOLA)
+         */
+        BatchLeastSquares(const size_t period, const uint32_t type = LSM_LINE) {
+            const size_t num_coeff = type == LSM_PARABOLA ? 3 : 2;
+            if(period < num_coeff) return;
+            std::vector<T> design(period * num_coeff);
+            for(size_t i = 0; i < period; ++i) {
+                T p = 1;
+                for(size_t k = 0; k < num_coeff; ++k) {
+                    design[k * period + i] = p;
+                    p *= (T)i;
+                }
+            }
+            LeastSquaresQR<T> qr;
+            if(qr.init(design, period, num_coeff) != xtechnical_common::OK) return;
+            /* столбцы P - решения для единичных векторов наблюдений */
+            projection_.resize(num_coeff * period);
+            std::vector<T> unit(period, T(0));
+            std::vector<T> column(num_coeff);
+            for(size_t i = 0; i < period; ++i) {
+                unit[i] = 1;
+                qr.solve(unit.data(), column.data());
+                unit[i] = 0;
+                for(size_t k = 0; k < num_coeff; ++k) {
+                    projection_[k * period + i] = column[k];
+                }
+            }
+            period_ = period;
+            num_coeff_ = num_coeff;
+        }
+
+        /** \brief Найти коэффициенты для множества выборок
+         * \param y значения выборок в формате SoA: y[bar * num_series + series], period баров
+         * \param num_series количество выборок
+         * \param coeff коэффициенты в формате SoA: coeff[k * num_series + series], k = 0 для A0
+         * \param start_bar строка y, в которой лежит самый старый бар (для кольцевого буфера)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2, typename T3>
+        int calc(const T2 *y, const size_t num_series, T3 *coeff, const size_t start_bar = 0) const {
+            if(period_ == 0) return xtechnical_common::NO_INIT;
+            if(start_bar >= period_) return xtechnical_common::INVALID_PARAMETER;
+            for(size_t k = 0; k < num_coeff_; ++k) {
+                T3 *out = coeff + k * num_series;
+                std::fill(out, out + num_series, T3(0));
+                const T *weights = &projection_[k * period_];
+                for(size_t i = 0; i < period_; ++i) {
+                    const size_t bar = start_bar + i < period_ ? start_bar + i : start_bar + i - period_;
+                    const T2 *row = y + bar * num_series;
+                    const T w = weights[i];
+                    for(size_t s = 0; s < num_series; ++s) {
+                        out[s] += w * row[s];
+                    }
+                }
+            }
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Найти коэффициенты для множества выборок
+         * \param y значения выборок в формате SoA, размер period * num_series
+         * \param num_series количество выборок
+         * \param coeff коэффициенты в формате SoA, размер get_num_coefficients() * num_series
+         * \param start_bar строка y, в которой лежит самый старый бар (для кольцевого буфера)
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2, typename T3>
+        int calc(
+                const std::vector<T2> &y,
+                const size_t num_series,
+                std::vector<T3> &coeff,
+                const size_t start_bar = 0) const {
+            if(period_ == 0) return xtechnical_common::NO_INIT;
+            if(y.size() != period_ * num_series) return xtechnical_common::INVALID_PARAMETER;
+            coeff.resize(num_coeff_ * num_series);
+            return calc(y.data(), num_series, coeff.data(), start_bar);
+        }
+
+        /** \brief Получить количество коэффициентов
+         * \return 2 для прямой, 3 для параболы
+         */
+        inline size_t get_num_coefficients() const {
+            return num_coeff_;
+        }
+    };
+
+    /** \brief Скользящая регрессия по методу наименьших квадратов
+     *
+     * Аппроксимирует последние period значений прямой или параболой.
+     * Внутри окна используются центрированные номера баров x = i - (period - 1) / 2,
+     * поэтому суммы x и x^3 равны нулю, суммы x^2 и x^4 постоянны, а суммы
+     * y, x*y, x^2*y и y^2 обновляются за O(1) при сдвиге окна.
+     * Значения хранятся относительно опорного уровня, а суммы раз в period
+     * баров пересчитываются заново, чтобы не накапливалась ошибка округления.
+     * Коэффициенты возвращаются для оси, где x = 0 соответствует последнему бару,
+     * x = -1 предыдущему и т.д. (Y = A2*X^2 + A1*X + A0, см. calc_line)
+     */
+    template <typename T>
+    class RollingLeastSquares {
+    private:
+
+        /// Суммы по окну
+        class Sums {
+        public:
+            T offset = 0;   ///< Опорный уровень, вычитается из значений
+            T y = 0;
+            T xy = 0;
+            T x2y = 0;
+            T y2 = 0;
+        };
+
+        std::vector<T> buffer_;
+        Sums sums_;
+        Sums test_sums_;
+        size_t period_ = 0;
+        size_t pos_ = 0;
+        size_t count_ = 0;
+        size_t updates_since_recalc_ = 0;
+        uint32_t type_ = LSM_LINE;
+        T center_ = 0;
+        T sum_x2_ = 0;
+        T sum_x4_ = 0;
+        bool is_test_ = false;
+
+        /** \brief Посчитать суммы по окну
+         * \param sums суммы окна
+         * \param start индекс самого старого значения в буфере
+         * \param last последнее значение окна
+         */
+        void calc_sums(Sums &sums, const size_t start, const T last) const {
+            sums = Sums();
+            sums.offset = last;
+            for(size_t i = 0; i < period_; ++i) {
+                const T x = (T)i - center_;
+                const T value = i + 1 == period_ ? last : buffer_[(start + i) % period_];
+                const T y = value - sums.offset;
+                const T xy = x * y;
+                sums.y += y;
+                sums.xy += xy;
+                sums.x2y += x * xy;
+                sums.y2 += y * y;
+            }
+        }
+
+        /** \brief Сдвинуть окно на один бар
+         * \param sums суммы окна
+         * \param old_value вытесняемое значение
+         * \param in новое значение
+         */
+        inline void shift(Sums &sums, const T old_value, const T in) const {
+            /* номера всех баров уменьшаются на 1 */
+            sums.x2y += sums.y - 2 * sums.xy;
+            sums.xy -= sums.y;
+            const T y_old = old_value - sums.offset;
+            const T x_old = -center_ - 1;
+            sums.y -= y_old;
+            sums.xy -= x_old * y_old;
+            sums.x2y -= x_old * x_old * y_old;
+            sums.y2 -= y_old * y_old;
+            const T y = in - sums.offset;
+            sums.y += y;
+            sums.xy += center_ * y;
+            sums.x2y += center_ * center_ * y;
+            sums.y2 += y * y;
+        }
+
+        inline bool check_init() const {
+            return period_ >= 2 && (type_ != LSM_PARABOLA || period_ >= 3);
+        }
+
+        inline bool is_ready() const {
+            return is_test_ || (check_init() && count_ == period_);
+        }
+
+        /** \brief Найти коэффициенты в центрированных координатах
+         * (значения относительно опорного уровня)
+         */
+        void calc_centered(T &a0, T &a1, T &a2) const {
+            const Sums &s = is_test_ ? test_sums_ : sums_;
+            const T n = (T)period_;
+            a1 = s.xy / sum_x2_;
+            if(type_ == LSM_PARABOLA) {
+                const T det = n * sum_x4_ - sum_x2_ * sum_x2_;
+                a2 = (n * s.x2y - sum_x2_ * s.y) / det;
+                a0 = (sum_x4_ * s.y - sum_x2_ * s.x2y) / det;
+            } else {
+                a2 = 0;
+                a0 = s.y / n;
+            }
+        }
+
+    public:
+
+        RollingLeastSquares() {};
+
+        /** \brief Инициализировать скользящую регрессию
+         * \param period период (не меньше 2 для прямой и 3 для параболы)
+         * \param type тип линии (LSM_LINE или LSM_PARABOLA)
+         */
+        RollingLeastSquares(const size_t period, const uint32_t type = LSM_LINE) :
+                buffer_(period), period_(period), type_(type) {
+            center_ = ((T)period_ - 1) / 2;
+            for(size_t i = 0; i < period_; ++i) {
+                const T x2 = ((T)i - center_) * ((T)i - center_);
+                sum_x2_ += x2;
+                sum_x4_ += x2 * x2;
+            }
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигнал на входе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T in) {
+            if(!check_init()) return xtechnical_common::NO_INIT;
+            is_test_ = false;
+            if(count_ < period_) {
+                buffer_[pos_] = in;
+                if(++pos_ == period_) pos_ = 0;
+                if(++count_ < period_) return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+                calc_sums(sums_, 0, in);
+                updates_since_recalc_ = 0;
+                return xtechnical_common::OK;
+            }
+            const T old_value = buffer_[pos_];
+            buffer_[pos_] = in;
+            if(++pos_ == period_) pos_ = 0;
+            if(++updates_since_recalc_ >= period_) {
+                calc_sums(sums_, pos_, in);
+                updates_since_recalc_ = 0;
+            } else {
+                shift(sums_, old_value, in);
+            }
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем,
+         * что не влияет на внутреннее состояние индикатора.
+         * Результат теста доступен через методы get_* до следующего вызова update
+         * \param in сигнал на входе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int test(const T in) {
+            if(!check_init()) return xtechnical_common::NO_INIT;
+            is_test_ = false;
+            if(count_ + 1 < period_) return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+            if(count_ < period_) {
+                /* окно заполняется тестовым значением */
+                calc_sums(test_sums_, 0, in);
+            } else {
+                test_sums_ = sums_;
+                shift(test_sums_, buffer_[pos_], in);
+            }
+            is_test_ = true;
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Получить коэффициенты регрессии
+         * \param coeff массив коэффициентов A0, A1, A2 (A2 только для LSM_PARABOLA), см. calc_line
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <typename T2>
+        int get_coefficients(T2 &coeff) const {
+            if(!is_ready()) return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+            T a0 = 0, a1 = 0, a2 = 0;
+            calc_centered(a0, a1, a2);
+            const Sums &s = is_test_ ? test_sums_ : sums_;
+            /* переход к оси, где последний бар имеет x = 0 */
+            coeff[0] = a0 + a1 * center_ + a2 * center_ * center_ + s.offset;
+            coeff[1] = a1 + 2 * a2 * center_;
+            if(type_ == LSM_PARABOLA) coeff[2] = a2;
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Получить наклон линии на последнем баре
+         * \return наклон (производная по номеру бара)
+         */
+        T get_slope() const {
+            T coeff[3] = {0, 0, 0};
+            get_coefficients(coeff);
+            return coeff[1];
+        }
+
+        /** \brief Получить значение линии на последнем баре
+         * \return значение линии
+         */
+        T get_intercept() const {
+            T coeff[3] = {0, 0, 0};
+            get_coefficients(coeff);
+            return coeff[0];
+        }
+
+        /** \brief Получить кривизну (коэффициент A2 параболы)
+         * \return кривизна, для прямой 0
+         */
+        T get_curvature() const {
+            T coeff[3] = {0, 0, 0};
+            get_coefficients(coeff);
+            return coeff[2];
+        }
+
+        /** \brief Получить коэффициент детерминации R^2
+         * \return коэффициент детерминации, 0 если данные постоянны
+         */
+        T get_r_squared() const {
+            if(!is_ready()) return 0;
+            T a0 = 0, a1 = 0, a2 = 0;
+            calc_centered(a0, a1, a2);
+            const Sums &s = is_test_ ? test_sums_ : sums_;
+            const T n = (T)period_;
+            const T ss_tot = s.y2 - s.y * s.y / n;
+            if(ss_tot <= 0) return 0;
+            const T ss_reg = a0 * s.y + a1 * s.xy + a2 * s.x2y - s.y * s.y / n;
+            return std::min(std::max(ss_reg / ss_tot, (T)0), (T)1);
+        }
+
+        /** \brief Получить прогноз
+         * \param bars_ahead количество баров вперед от последнего бара
+         * \return прогнозируемое значение
+         */
+        T get_forecast(const T bars_ahead) const {
+            T coeff[3] = {0, 0, 0};
+            if(get_coefficients(coeff) != xtechnical_common::OK) return 0;
+            return calc_line(coeff, bars_ahead, type_);
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            std::fill(buffer_.begin(), buffer_.end(), T(0));
+            sums_ = Sums();
+            test_sums_ = Sums();
+            pos_ = 0;
+            count_ = 0;
+            updates_since_recalc_ = 0;
+            is_test_ = false;
+        }
+    };
 }
 
 #endif // XTECHNICAL_REGRESSION_ANALYSIS_HPP_INCLUDED
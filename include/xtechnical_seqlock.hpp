@@ -0,0 +1,238 @@
+/*
+* xtechnical_analysis - Technical analysis C++ library
+*
+* Copyright (c) 2018 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef XTECHNICAL_SEQLOCK_HPP_INCLUDED
+#define XTECHNICAL_SEQLOCK_HPP_INCLUDED
+
+#include "xtechnical_common.hpp"
+#include <atomic>
+#include <thread>
+#include <cstdint>
+#include <cstddef>
+
+namespace xtechnical_indicators {
+    using namespace xtechnical_common;
+
+    /** \brief Ячейка для публикации значений одним потоком (seqlock)
+     *
+     * Писатель никогда не ждет читателей. Читатель копирует значения и
+     * повторяет чтение, если за это время они изменились, поэтому всегда
+     * получает согласованный набор значений. Данные ячейки окружены отступами
+     * в линию кэша, чтобы не делить линии с соседними данными (alignas не
+     * подходит: в C++11 operator new не учитывает такое выравнивание)
+     * \tparam T тип значений (копируемый побитово)
+     * \tparam N количество значений
+     */
+    template <class T, size_t N = 1>
+    class SeqlockSlot {
+    private:
+        char pad_0_[CACHE_LINE_SIZE];
+        std::atomic<uint64_t> sequence_;    /**< нечетное значение - идет запись */
+        std::atomic<int> status_;
+        std::atomic<T> values_[N];
+        char pad_1_[CACHE_LINE_SIZE];
+
+    public:
+
+        SeqlockSlot() : sequence_(0), status_(INDICATOR_NOT_READY_TO_WORK) {
+            for(size_t i = 0; i < N; ++i) {
+                values_[i].store(T(), std::memory_order_relaxed);
+            }
+        }
+
+        SeqlockSlot(const SeqlockSlot &) = delete;
+        SeqlockSlot &operator=(const SeqlockSlot &) = delete;
+
+        /** \brief Опубликовать значения (только поток писателя)
+         * \param values значения, N штук
+         * \param status состояние индикатора
+         */
+        void write(const T *values, const int status) {
+            const uint64_t sequence = sequence_.load(std::memory_order_relaxed);
+            sequence_.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            for(size_t i = 0; i < N; ++i) {
+                values_[i].store(values[i], std::memory_order_relaxed);
+            }
+            status_.store(status, std::memory_order_relaxed);
+            sequence_.store(sequence + 2, std::memory_order_release);
+        }
+
+        /** \brief Попробовать прочитать значения
+         * \param values значения, N штук
+         * \param status состояние индикатора
+         * \param version номер публикации (0 - значения еще не публиковались)
+         * \return вернет false, если во время чтения шла запись
+         */
+        bool try_read(T *values, int &status, uint64_t &version) const {
+            const uint64_t sequence = sequence_.load(std::memory_order_acquire);
+            if(sequence & 1) return false;
+            for(size_t i = 0; i < N; ++i) {
+                values[i] = values_[i].load(std::memory_order_relaxed);
+            }
+            const int temp_status = status_.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if(sequence_.load(std::memory_order_relaxed) != sequence) return false;
+            status = temp_status;
+            version = sequence / 2;
+            return true;
+        }
+
+        /** \brief Прочитать значения
+         * \param values значения, N штук
+         * \param version номер публикации (0 - значения еще не публиковались)
+         * \return состояние индикатора на момент публикации, см. ErrorType
+         */
+        int read(T *values, uint64_t *version = NULL) const {
+            int status = INDICATOR_NOT_READY_TO_WORK;
+            uint64_t temp_version = 0;
+            size_t attempt = 0;
+            while(!try_read(values, status, temp_version)) {
+                if(++attempt > 64) std::this_thread::yield();
+            }
+            if(version) *version = temp_version;
+            return status;
+        }
+
+        /** \brief Получить номер последней публикации
+         */
+        inline uint64_t get_version() const {
+            return sequence_.load(std::memory_order_acquire) / 2;
+        }
+    };
+
+    /** \brief Вызов update индикатора с N выходами
+     */
+    template <size_t N>
+    class SeqlockUpdate;
+
+    template <>
+    class SeqlockUpdate<1> {
+    public:
+        template <class INDICATOR_TYPE, class T, class... ARGS>
+        static int update(INDICATOR_TYPE &indicator, T *out, const ARGS&... in) {
+            return indicator.update(in..., out[0]);
+        }
+    };
+
+    template <>
+    class SeqlockUpdate<2> {
+    public:
+        template <class INDICATOR_TYPE, class T, class... ARGS>
+        static int update(INDICATOR_TYPE &indicator, T *out, const ARGS&... in) {
+            return indicator.update(in..., out[0], out[1]);
+        }
+    };
+
+    template <>
+    class SeqlockUpdate<3> {
+    public:
+        template <class INDICATOR_TYPE, class T, class... ARGS>
+        static int update(INDICATOR_TYPE &indicator, T *out, const ARGS&... in) {
+            return indicator.update(in..., out[0], out[1], out[2]);
+        }
+    };
+
+    template <>
+    class SeqlockUpdate<4> {
+    public:
+        template <class INDICATOR_TYPE, class T, class... ARGS>
+        static int update(INDICATOR_TYPE &indicator, T *out, const ARGS&... in) {
+            return indicator.update(in..., out[0], out[1], out[2], out[3]);
+        }
+    };
+
+    /** \brief Индикатор с публикацией значений для других потоков
+     *
+     * Обертка над любым индикатором: после каждого update выходы индикатора
+     * и его состояние записываются в SeqlockSlot, откуда их без блокировок
+     * читают другие потоки. update вызывает один поток
+     * \tparam INDICATOR_TYPE тип индикатора
+     * \tparam T тип значений
+     * \tparam N количество выходов update (например, 3 для BollingerBands)
+     */
+    template <class INDICATOR_TYPE, class T = double, size_t N = 1>
+    class PublishedIndicator {
+    private:
+        SeqlockSlot<T, N> slot_;
+        INDICATOR_TYPE indicator_;
+
+    public:
+
+        /** \brief Инициализировать индикатор
+         * \param args аргументы конструктора индикатора
+         */
+        template <class... ARGS>
+        PublishedIndicator(const ARGS&... args) : indicator_(args...) {}
+
+        /** \brief Обновить состояние индикатора и опубликовать выходы
+         * \param in сигналы на входе индикатора
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <class... ARGS>
+        int update(const ARGS&... in) {
+            T out[N];
+            for(size_t i = 0; i < N; ++i) out[i] = T();
+            const int err = SeqlockUpdate<N>::update(indicator_, out, in...);
+            slot_.write(out, err);
+            return err;
+        }
+
+        /** \brief Получить опубликованные выходы (любой поток)
+         * \param out выходы индикатора, N штук
+         * \param version номер публикации
+         * \return состояние индикатора на момент публикации, см. ErrorType
+         */
+        int get(T *out, uint64_t *version = NULL) const {
+            return slot_.read(out, version);
+        }
+
+        /** \brief Получить первый опубликованный выход (любой поток)
+         * \param out выход индикатора
+         * \return состояние индикатора на момент публикации, см. ErrorType
+         */
+        int get(T &out) const {
+            T temp[N];
+            const int err = slot_.read(temp);
+            out = temp[0];
+            return err;
+        }
+
+        /** \brief Получить индикатор (только поток писателя)
+         */
+        inline INDICATOR_TYPE &get_indicator() {
+            return indicator_;
+        }
+
+        /** \brief Очистить данные индикатора и опубликовать это
+         */
+        void clear() {
+            indicator_.clear();
+            T out[N];
+            for(size_t i = 0; i < N; ++i) out[i] = T();
+            slot_.write(out, INDICATOR_NOT_READY_TO_WORK);
+        }
+    };
+}
+
+#endif // XTECHNICAL_SEQLOCK_HPP_INCLUDED
@@ -0,0 +1,391 @@
+/*
+* xtechnical_analysis - Technical analysis C++ library
+*
+* Copyright (c) 2018 Elektro Yar. Email: git.electroyar@gmail.com
+*
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*
+* The above copyright notice and this permission notice shall be included in
+* all copies or substantial portions of the Software.
+*
+* THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+* IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+* FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+* AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+* LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+* OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+* SOFTWARE.
+*/
+#ifndef XTECHNICAL_SHARDED_RUNTIME_HPP_INCLUDED
+#define XTECHNICAL_SHARDED_RUNTIME_HPP_INCLUDED
+
+#include "xtechnical_common.hpp"
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <cstddef>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace xtechnical_indicators {
+    using namespace xtechnical_common;
+
+    /** \brief Очередь без блокировок для одного писателя и одного читателя
+     */
+    template <class T>
+    class SpscQueue {
+    private:
+        std::vector<T> data_;
+        size_t mask_ = 0;
+        char pad_0_[CACHE_LINE_SIZE];
+        std::atomic<size_t> head_;      /**< индекс записи, меняет только писатель */
+        char pad_1_[CACHE_LINE_SIZE];
+        std::atomic<size_t> tail_;      /**< индекс чтения, меняет только читатель */
+        char pad_2_[CACHE_LINE_SIZE];
+
+    public:
+
+        /** \brief Инициализировать очередь
+         * \param capacity вместимость, округляется вверх до степени двойки
+         */
+        SpscQueue(const size_t capacity) : head_(0), tail_(0) {
+            size_t size = 1;
+            while(size < capacity) size <<= 1;
+            data_.resize(size);
+            mask_ = size - 1;
+        }
+
+        /** \brief Добавить элемент (только поток писателя)
+         * \param item элемент
+         * \return вернет false, если очередь заполнена
+         */
+        bool push(const T &item) {
+            const size_t head = head_.load(std::memory_order_relaxed);
+            if(head - tail_.load(std::memory_order_acquire) > mask_) return false;
+            data_[head & mask_] = item;
+            head_.store(head + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** \brief Извлечь элемент (только поток читателя)
+         * \param item элемент
+         * \return вернет false, если очередь пуста
+         */
+        bool pop(T &item) {
+            const size_t tail = tail_.load(std::memory_order_relaxed);
+            if(tail == head_.load(std::memory_order_acquire)) return false;
+            item = data_[tail & mask_];
+            tail_.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        /** \brief Проверить, пуста ли очередь
+         */
+        bool empty() const {
+            return tail_.load(std::memory_order_acquire) == head_.load(std::memory_order_acquire);
+        }
+    };
+
+    /** \brief Многопоточная обработка индикаторов множества символов
+     *
+     * Символы делятся между рабочими потоками (символ s обрабатывает поток
+     * s % num_threads). Поток создает индикаторы своих символов сам, поэтому
+     * их память принадлежит ему, а данные разных потоков разделены линиями
+     * кэша. Тики передаются каждому потоку через свою очередь одного писателя
+     * и одного читателя, последние значения индикаторов публикуются через
+     * атомарные переменные и читаются из любого потока без блокировок.
+     * Поток без тиков сначала крутится в цикле, затем уступает процессор,
+     * а затем засыпает на условной переменной до следующего тика, поэтому
+     * простаивающие потоки не занимают ядра.
+     *
+     * Методы update и wait должен вызывать один поток, get - любой поток
+     */
+    template <class T, class INDICATOR_TYPE>
+    class ShardedRuntime {
+    private:
+
+        /// Тик символа внутри потока
+        class Tick {
+        public:
+            size_t index = 0;   /**< номер символа внутри потока */
+            T value = 0;
+        };
+
+        /// Опубликованное значение индикатора
+        class Result {
+        public:
+            std::atomic<T> value;
+            std::atomic<uint8_t> is_ready;
+
+            Result() : value(0), is_ready(0) {}
+        };
+
+        /// Данные одного потока
+        class Shard {
+        public:
+            char pad_0_[CACHE_LINE_SIZE];
+            SpscQueue<Tick> queue;
+            std::vector<INDICATOR_TYPE> indicators;
+            std::unique_ptr<Result[]> results;
+            size_t num_symbols = 0;
+            char pad_1_[CACHE_LINE_SIZE];
+            std::atomic<uint64_t> processed;    /**< число обработанных тиков, меняет поток */
+            char pad_2_[CACHE_LINE_SIZE];
+            uint64_t pushed = 0;                /**< число отправленных тиков, меняет писатель */
+            char pad_3_[CACHE_LINE_SIZE];
+            std::atomic<bool> is_sleeping;      /**< поток ждет на условной переменной */
+            std::mutex mutex;
+            std::condition_variable condition;
+            std::thread thread;
+
+            Shard(const size_t symbols, const size_t queue_size) :
+                queue(queue_size), results(new Result[symbols]),
+                num_symbols(symbols), processed(0), is_sleeping(false) {}
+        };
+
+        std::vector<std::unique_ptr<Shard>> shards_;
+        INDICATOR_TYPE prototype_;
+        size_t num_symbols_ = 0;
+        std::atomic<bool> is_stop_;
+
+        enum {
+            SPIN_COUNT = 64,    ///< Число пустых проверок очереди до уступки процессора
+            YIELD_COUNT = 64,   ///< Число уступок процессора до сна на условной переменной
+        };
+
+        /** \brief Получить список ядер, доступных процессу
+         *
+         * В Linux учитывается маска sched_getaffinity, иначе берутся
+         * ядра от 0 до hardware_concurrency - 1
+         */
+        static std::vector<size_t> get_allowed_cpus() {
+            std::vector<size_t> cpus;
+#           if defined(__linux__)
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            if(sched_getaffinity(0, sizeof(cpu_set), &cpu_set) == 0) {
+                for(size_t cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+                    if(CPU_ISSET(cpu, &cpu_set)) cpus.push_back(cpu);
+                }
+            }
+#           endif
+            if(cpus.empty()) {
+                const size_t num_cores = std::max((size_t)std::thread::hardware_concurrency(), (size_t)1);
+                for(size_t cpu = 0; cpu < num_cores; ++cpu) {
+                    cpus.push_back(cpu);
+                }
+            }
+            return cpus;
+        }
+
+        static void pin_thread(const size_t cpu) {
+#           if defined(__linux__)
+            cpu_set_t cpu_set;
+            CPU_ZERO(&cpu_set);
+            CPU_SET(cpu, &cpu_set);
+            pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set);
+#           else
+            (void)cpu;
+#           endif
+        }
+
+        void run(Shard &shard, const bool is_pinned, const size_t cpu) {
+            if(is_pinned) pin_thread(cpu);
+            shard.indicators.assign(shard.num_symbols, prototype_);
+            Tick tick;
+            size_t idle = 0;
+            uint64_t processed = 0;
+            while(true) {
+                if(shard.queue.pop(tick)) {
+                    T out = 0;
+                    if(shard.indicators[tick.index].update(tick.value, out) == OK) {
+                        Result &result = shard.results[tick.index];
+                        result.value.store(out, std::memory_order_release);
+                        result.is_ready.store(1, std::memory_order_release);
+                    }
+                    shard.processed.store(++processed, std::memory_order_release);
+                    idle = 0;
+                    continue;
+                }
+                if(is_stop_.load(std::memory_order_acquire)) {
+                    if(shard.queue.empty()) break;
+                    continue;
+                }
+                ++idle;
+                if(idle <= SPIN_COUNT) continue;
+                if(idle <= SPIN_COUNT + YIELD_COUNT) {
+                    std::this_thread::yield();
+                    continue;
+                }
+                wait_for_tick(shard);
+                idle = 0;
+            }
+        }
+
+        /** \brief Уснуть до появления тика в очереди или остановки
+         *
+         * Флаг is_sleeping и очередь проверяются крест-накрест с update
+         * через барьеры seq_cst: либо поток увидит новый тик, либо писатель
+         * увидит флаг и разбудит поток
+         */
+        void wait_for_tick(Shard &shard) {
+            std::unique_lock<std::mutex> lock(shard.mutex);
+            shard.is_sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            while(shard.queue.empty() && !is_stop_.load(std::memory_order_acquire)) {
+                shard.condition.wait(lock);
+            }
+            shard.is_sleeping.store(false, std::memory_order_relaxed);
+        }
+
+        /** \brief Разбудить поток, если он спит
+         */
+        static void wake(Shard &shard) {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if(!shard.is_sleeping.load(std::memory_order_relaxed)) return;
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.condition.notify_one();
+        }
+
+        /** \brief Остановить и дождаться все запущенные потоки
+         */
+        void stop() {
+            is_stop_.store(true, std::memory_order_release);
+            for(size_t i = 0; i < shards_.size(); ++i) {
+                Shard &shard = *shards_[i];
+                {
+                    std::lock_guard<std::mutex> lock(shard.mutex);
+                    shard.condition.notify_one();
+                }
+                if(shard.thread.joinable()) shard.thread.join();
+            }
+        }
+
+    public:
+
+        /** \brief Инициализировать обработку
+         * \param num_symbols количество символов
+         * \param prototype индикатор, копия которого создается для каждого символа
+         * \param num_threads количество потоков (0 - на один меньше числа доступных
+         * процессу ядер, чтобы одно ядро осталось потоку, вызывающему update)
+         * \param queue_size размер очереди тиков одного потока
+         * \param is_pinned закрепить потоки за доступными процессу ядрами, кроме первого (только Linux)
+         */
+        ShardedRuntime(
+                const size_t num_symbols,
+                const INDICATOR_TYPE &prototype,
+                size_t num_threads = 0,
+                const size_t queue_size = 16384,
+                const bool is_pinned = true) :
+                prototype_(prototype), num_symbols_(num_symbols), is_stop_(false) {
+            const std::vector<size_t> cpus = get_allowed_cpus();
+            if(num_threads == 0) num_threads = cpus.size() > 1 ? cpus.size() - 1 : 1;
+            num_threads = std::max(std::min(num_threads, num_symbols), (size_t)1);
+            for(size_t i = 0; i < num_threads; ++i) {
+                const size_t symbols = num_symbols / num_threads + (i < num_symbols % num_threads ? 1 : 0);
+                shards_.push_back(std::unique_ptr<Shard>(new Shard(symbols, queue_size)));
+            }
+            /* если поток не удалось создать, уже запущенные потоки останавливаются,
+             * иначе деструктор std::thread вызвал бы std::terminate
+             */
+            try {
+                for(size_t i = 0; i < num_threads; ++i) {
+                    shards_[i]->thread = std::thread(&ShardedRuntime::run, this,
+                        std::ref(*shards_[i]), is_pinned, cpus[(i + 1) % cpus.size()]);
+                }
+            } catch(...) {
+                stop();
+                throw;
+            }
+        }
+
+        ShardedRuntime(const ShardedRuntime &) = delete;
+        ShardedRuntime &operator=(const ShardedRuntime &) = delete;
+
+        ~ShardedRuntime() {
+            stop();
+        }
+
+        /** \brief Отправить тик символа
+         *
+         * Если очередь потока заполнена, ждет освобождения места
+         * \param symbol номер символа
+         * \param in значение
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const size_t symbol, const T in) {
+            if(symbol >= num_symbols_) return INVALID_PARAMETER;
+            Shard &shard = *shards_[symbol % shards_.size()];
+            Tick tick;
+            tick.index = symbol / shards_.size();
+            tick.value = in;
+            while(!shard.queue.push(tick)) std::this_thread::yield();
+            ++shard.pushed;
+            wake(shard);
+            return OK;
+        }
+
+        /** \brief Отправить тики всех символов
+         * \param in значения, по одному на символ
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        template <class T1>
+        int update(const T1 &in) {
+            if(in.size() != num_symbols_) return INVALID_PARAMETER;
+            for(size_t s = 0; s < num_symbols_; ++s) {
+                update(s, in[s]);
+            }
+            return OK;
+        }
+
+        /** \brief Дождаться обработки всех отправленных тиков
+         */
+        void wait() {
+            for(size_t i = 0; i < shards_.size(); ++i) {
+                const Shard &shard = *shards_[i];
+                while(shard.processed.load(std::memory_order_acquire) != shard.pushed) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        /** \brief Получить последнее значение индикатора символа
+         * \param symbol номер символа
+         * \param out значение индикатора
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int get(const size_t symbol, T &out) const {
+            if(symbol >= num_symbols_) return INVALID_PARAMETER;
+            const Result &result = shards_[symbol % shards_.size()]->results[symbol / shards_.size()];
+            if(!result.is_ready.load(std::memory_order_acquire)) return INDICATOR_NOT_READY_TO_WORK;
+            out = result.value.load(std::memory_order_acquire);
+            return OK;
+        }
+
+        /** \brief Получить количество потоков
+         */
+        inline size_t get_num_threads() const {
+            return shards_.size();
+        }
+
+        /** \brief Получить количество символов
+         */
+        inline size_t get_num_symbols() const {
+            return num_symbols_;
+        }
+    };
+}
+
+#endif // XTECHNICAL_SHARDED_RUNTIME_HPP_INCLUDED
@@ -1,8 +1,14 @@
 #ifndef XTECHNICAL_STATISTICS_HPP_INCLUDED
 #define XTECHNICAL_STATISTICS_HPP_INCLUDED
 
+#include "xtechnical_common.hpp"
 #include <cmath>
 #include <algorithm>
+#include <iterator>
+#include <vector>
+#include <set>
+#include <cstring>
+#include <cstdint>
 
 namespace xtechnical_statistics {
 
@@ -69,34 +75,343 @@ namespace xtechnical_statistics {
         return std::pow(sum, 1.0/(T1)size);
     };
 
+    /** \brief Посчитать медиану, переставив элементы массива
+     *
+     * Используется выбор элемента (std::nth_element) за O(n) вместо сортировки
+     * \param array_data Массив с данными, порядок элементов будет изменен
+     * \return медиана
+     */
+    template<class T1, class T2>
+    T1 calc_median_in_place(T2 &array_data) {
+        const size_t size = array_data.size();
+        if(size == 0) return (T1)0;
+        std::nth_element(array_data.begin(), array_data.begin() + size/2, array_data.end());
+        return array_data[size/2];
+    };
+
+    /** \brief Посчитать медиану
+     * \param array_data Массив с данными
+     * \param buffer Буфер для копии данных, чтобы не выделять память при каждом вызове
+     * \return медиана
+     */
+    template<class T1, class T2>
+    T1 calc_median(const T2 &array_data, std::vector<T1> &buffer) {
+        buffer.assign(array_data.begin(), array_data.end());
+        return calc_median_in_place<T1>(buffer);
+    };
+
     /** \brief Посчитать медиану
      * \param array_data Массив с данными
      * \return медиана
      */
     template<class T1, class T2>
-    T1 calc_median(T2 array_data) {
+    T1 calc_median(const T2 &array_data) {
+        std::vector<T1> buffer;
+        return calc_median<T1>(array_data, buffer);
+    };
+
+    /** \brief Посчитать квантиль, переставив элементы массива
+     *
+     * Квантиль считается линейной интерполяцией между соседними
+     * порядковыми статистиками (позиция quantile * (n - 1)).
+     * Используется выбор элемента (std::nth_element) за O(n) вместо сортировки
+     * \param array_data Массив с данными, порядок элементов будет изменен
+     * \param quantile Уровень квантиля от 0 до 1
+     * \return квантиль
+     */
+    template<class T1, class T2>
+    T1 calc_quantile_in_place(T2 &array_data, const T1 quantile) {
         const size_t size = array_data.size();
-        std::sort(array_data.begin(),array_data.end());
-        return array_data[size/2];
+        if(size == 0) return (T1)0;
+        const T1 q = std::min(std::max(quantile, (T1)0), (T1)1);
+        const T1 h = q * (T1)(size - 1);
+        const size_t k = std::min((size_t)h, size - 1);
+        const T1 frac = h - (T1)k;
+        std::nth_element(array_data.begin(), array_data.begin() + k, array_data.end());
+        const T1 lower = array_data[k];
+        if(frac == 0 || k + 1 == size) return lower;
+        const T1 upper = *std::min_element(array_data.begin() + k + 1, array_data.end());
+        return lower + frac * (upper - lower);
+    };
+
+    /** \brief Посчитать квантиль
+     * \param array_data Массив с данными
+     * \param quantile Уровень квантиля от 0 до 1
+     * \param buffer Буфер для копии данных, чтобы не выделять память при каждом вызове
+     * \return квантиль
+     */
+    template<class T1, class T2>
+    T1 calc_quantile(const T2 &array_data, const T1 quantile, std::vector<T1> &buffer) {
+        buffer.assign(array_data.begin(), array_data.end());
+        return calc_quantile_in_place<T1>(buffer, quantile);
+    };
+
+    /** \brief Посчитать квантиль
+     * \param array_data Массив с данными
+     * \param quantile Уровень квантиля от 0 до 1
+     * \return квантиль
+     */
+    template<class T1, class T2>
+    T1 calc_quantile(const T2 &array_data, const T1 quantile) {
+        std::vector<T1> buffer;
+        return calc_quantile<T1>(array_data, quantile, buffer);
+    };
+
+    /** \brief Скользящий квантиль
+     *
+     * Окно делится на два упорядоченных множества: нижнее хранит
+     * floor(quantile * (n - 1)) + 1 наименьших элементов, верхнее - остальные.
+     * Квантиль берется с границы множеств, обновление занимает O(log n).
+     * Квантиль интерполируется так же, как в calc_quantile
+     */
+    template<class T>
+    class RollingQuantile {
+    private:
+        std::vector<T> buffer_;
+        std::multiset<T> low_;
+        std::multiset<T> high_;
+        T quantile_ = 0.5;
+        size_t period_ = 0;
+        size_t pos_ = 0;
+        size_t count_ = 0;
+
+        void insert_value(const T value) {
+            if(!low_.empty() && value <= *low_.rbegin()) low_.insert(value);
+            else high_.insert(value);
+        }
+
+        void erase_value(const T value) {
+            if(!low_.empty() && value <= *low_.rbegin()) low_.erase(low_.find(value));
+            else high_.erase(high_.find(value));
+        }
+
+        void rebalance() {
+            const size_t n = low_.size() + high_.size();
+            const size_t low_size = n == 0 ? 0 : (size_t)(quantile_ * (T)(n - 1)) + 1;
+            while(low_.size() > low_size) {
+                typename std::multiset<T>::iterator it = std::prev(low_.end());
+                high_.insert(*it);
+                low_.erase(it);
+            }
+            while(low_.size() < low_size) {
+                low_.insert(*high_.begin());
+                high_.erase(high_.begin());
+            }
+        }
+
+        T get_value() const {
+            const size_t n = low_.size() + high_.size();
+            const T h = quantile_ * (T)(n - 1);
+            const T frac = h - (T)(low_.size() - 1);
+            const T lower = *low_.rbegin();
+            if(frac <= 0 || high_.empty()) return lower;
+            return lower + frac * (*high_.begin() - lower);
+        }
+
+    public:
+
+        RollingQuantile() {};
+
+        /** \brief Инициализировать скользящий квантиль
+         * \param period Период
+         * \param quantile Уровень квантиля от 0 до 1, по умолчанию медиана
+         */
+        RollingQuantile(const size_t period, const T quantile = 0.5) :
+                buffer_(period),
+                quantile_(std::min(std::max(quantile, (T)0), (T)1)),
+                period_(period) {
+        }
+
+        /** \brief Обновить состояние индикатора
+         * \param in сигнал на входе
+         * \param out сигнал на выходе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int update(const T in, T &out) {
+            if(period_ == 0) {
+                out = 0;
+                return xtechnical_common::NO_INIT;
+            }
+            insert_value(in);
+            if(count_ == period_) erase_value(buffer_[pos_]);
+            else ++count_;
+            buffer_[pos_] = in;
+            if(++pos_ == period_) pos_ = 0;
+            rebalance();
+            if(count_ < period_) {
+                out = 0;
+                return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+            }
+            out = get_value();
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Протестировать индикатор
+         *
+         * Данная функция отличается от update тем,
+         * что не влияет на внутреннее состояние индикатора
+         * \param in сигнал на входе
+         * \param out сигнал на выходе
+         * \return вернет 0 в случае успеха, иначе см. ErrorType
+         */
+        int test(const T in, T &out) {
+            if(period_ == 0) {
+                out = 0;
+                return xtechnical_common::NO_INIT;
+            }
+            if(count_ + 1 < period_) {
+                out = 0;
+                return xtechnical_common::INDICATOR_NOT_READY_TO_WORK;
+            }
+            const bool is_full = count_ == period_;
+            const T old_value = buffer_[pos_];
+            insert_value(in);
+            if(is_full) erase_value(old_value);
+            rebalance();
+            out = get_value();
+            /* возвращаем состояние */
+            erase_value(in);
+            if(is_full) insert_value(old_value);
+            rebalance();
+            return xtechnical_common::OK;
+        }
+
+        /** \brief Получить значение квантиля
+         * \return значение квантиля или 0, если окно не заполнено
+         */
+        inline T get_quantile() const {
+            if(period_ == 0 || count_ < period_) return (T)0;
+            return get_value();
+        }
+
+        /** \brief Очистить данные индикатора
+         */
+        void clear() {
+            low_.clear();
+            high_.clear();
+            std::fill(buffer_.begin(), buffer_.end(), T(0));
+            pos_ = 0;
+            count_ = 0;
+        }
     };
 
+    /** \brief Описательные статистики выборки
+     *
+     * Поля считаются так же, как соответствующие функции calc_*
+     */
+    template<class T>
+    struct DescriptiveStats {
+        size_t size = 0;                ///< Размер выборки
+        T mean = 0;                     ///< Среднее значение
+        T variance = 0;                 ///< Дисперсия выборки (n - 1)
+        T std_dev = 0;                  ///< Стандартное отклонение выборки, см. calc_std_dev_sample
+        T std_dev_population = 0;       ///< Стандартное отклонение популяции, см. calc_std_dev_population
+        T skewness = 0;                 ///< Асимметрия, см. calc_skewness
+        T excess = 0;                   ///< Коэффициент эксцесса, см. calc_excess
+        T coefficient_variance = 0;     ///< Коэффициент вариации, см. calc_coefficient_variance
+        T signal_to_noise_ratio = 0;    ///< Отношение сигнал / шум, см. calc_signal_to_noise_ratio
+        T standard_error = 0;           ///< Стандартная ошибка, см. calc_standard_error
+        T min = 0;                      ///< Минимальное значение
+        T max = 0;                      ///< Максимальное значение
+    };
+
+    /** \brief Посчитать описательные статистики за один проход
+     *
+     * Степенные суммы отклонений от первого элемента накапливаются блоками
+     * в независимых аккумуляторах (векторизуется компилятором), суммы блоков
+     * складываются с компенсацией ошибки (Кэхэн). Центральные моменты
+     * получаются из степенных сумм.
+     * \param array_data Массив с данными
+     * \return описательные статистики
+     */
+    template<class T1, class T2>
+    DescriptiveStats<T1> calc_descriptive_stats(const T2 &array_data) {
+        DescriptiveStats<T1> stats;
+        const size_t size = array_data.size();
+        stats.size = size;
+        if(size == 0) return stats;
+
+        const size_t LANES = 4;
+        const size_t BLOCK_SIZE = 256;
+        const T1 shift = array_data[0];
+        T1 sum[4] = {0, 0, 0, 0};
+        T1 comp[4] = {0, 0, 0, 0};
+        T1 min_lane[LANES], max_lane[LANES];
+        for(size_t l = 0; l < LANES; ++l) {
+            min_lane[l] = max_lane[l] = shift;
+        }
+        for(size_t block = 0; block < size; block += BLOCK_SIZE) {
+            const size_t block_end = std::min(block + BLOCK_SIZE, size);
+            T1 s1[LANES] = {0}, s2[LANES] = {0}, s3[LANES] = {0}, s4[LANES] = {0};
+            size_t i = block;
+            for(; i + LANES <= block_end; i += LANES) {
+                for(size_t l = 0; l < LANES; ++l) {
+                    const T1 value = array_data[i + l];
+                    min_lane[l] = std::min(min_lane[l], value);
+                    max_lane[l] = std::max(max_lane[l], value);
+                    const T1 d = value - shift;
+                    const T1 d2 = d * d;
+                    s1[l] += d;
+                    s2[l] += d2;
+                    s3[l] += d2 * d;
+                    s4[l] += d2 * d2;
+                }
+            }
+            for(; i < block_end; ++i) {
+                const T1 value = array_data[i];
+                min_lane[0] = std::min(min_lane[0], value);
+                max_lane[0] = std::max(max_lane[0], value);
+                const T1 d = value - shift;
+                const T1 d2 = d * d;
+                s1[0] += d;
+                s2[0] += d2;
+                s3[0] += d2 * d;
+                s4[0] += d2 * d2;
+            }
+            const T1 block_sum[4] = {
+                (s1[0] + s1[1]) + (s1[2] + s1[3]),
+                (s2[0] + s2[1]) + (s2[2] + s2[3]),
+                (s3[0] + s3[1]) + (s3[2] + s3[3]),
+                (s4[0] + s4[1]) + (s4[2] + s4[3])};
+            for(size_t k = 0; k < 4; ++k) {
+                const T1 y = block_sum[k] - comp[k];
+                const T1 t = sum[k] + y;
+                comp[k] = (t - sum[k]) - y;
+                sum[k] = t;
+            }
+        }
+        stats.min = *std::min_element(min_lane, min_lane + LANES);
+        stats.max = *std::max_element(max_lane, max_lane + LANES);
+
+        /* центральные моменты (суммы степеней отклонений от среднего) */
+        const T1 n = (T1)size;
+        const T1 a = sum[0] / n;
+        stats.mean = shift + a;
+        T1 m2 = sum[1] - a * sum[0];
+        if(m2 < 0) m2 = 0;
+        const T1 m3 = sum[2] - 3 * a * sum[1] + 2 * a * a * sum[0];
+        const T1 m4 = sum[3] - 4 * a * sum[2] + 6 * a * a * sum[1] - 3 * a * a * a * sum[0];
+        stats.std_dev_population = std::sqrt(m2 / n);
+        if(size < 2) return stats;
+
+        stats.variance = m2 / (n - 1);
+        stats.std_dev = std::sqrt(stats.variance);
+        const T1 n_dec = n - 1;
+        stats.skewness = m3 / (n_dec * n_dec * n_dec);
+        stats.excess = (m4 / n) / (stats.variance * stats.variance) - 3.0;
+        stats.coefficient_variance = stats.std_dev / stats.mean;
+        stats.signal_to_noise_ratio = stats.mean / stats.std_dev;
+        stats.standard_error = stats.std_dev / std::sqrt(n);
+        return stats;
+    }
+
     /** \brief Посчитать стандартное отклонение выборки
      * \param array_data Массив с данными
      * \return стандартное отклонение выборки
      */
     template<class T1, class T2>
     T1 calc_std_dev_sample(const T2 &array_data) {
-        const size_t size = array_data.size();
-		if(size < 2) return (T1)0;
-        T1 mean = calc_mean_value<T1>(array_data);
-        T1 sum = 0;
-        for(size_t i = 0; i < size; ++i) {
-            T1 diff = array_data[i] - mean;
-            diff*=diff;
-            sum += diff;
-        }
-        sum /= (T1)(size - 1);
-        return std::sqrt(sum);
+        return calc_descriptive_stats<T1>(array_data).std_dev;
     };
 
     /** \brief Посчитать стандартное отклонение популяции
@@ -105,17 +420,7 @@ namespace xtechnical_statistics {
      */
     template<class T1, class T2>
     T1 calc_std_dev_population(const T2 &array_data) {
-        const size_t size = array_data.size();
-		if(size == 0) return (T1)0;
-        T1 mean = calc_mean_value<T1>(array_data);
-        T1 sum = 0;
-        for(size_t i = 0; i < size; ++i) {
-            T1 diff = array_data[i] - mean;
-            diff*=diff;
-            sum += diff;
-        }
-        sum /= (T1)(size);
-        return std::sqrt(sum);
+        return calc_descriptive_stats<T1>(array_data).std_dev_population;
     };
 
     /** \brief Посчитать среднее абсолютное отклонение
@@ -149,19 +454,7 @@ namespace xtechnical_statistics {
      */
     template<class T1, class T2>
     T1 calc_skewness(const T2 &array_data) {
-        T1 mean = calc_mean_value<T1>(array_data);
-        const size_t size = array_data.size();
-        if(size < 2) return (T1)0;
-        T1 sum = 0;
-        for(size_t i = 0; i < size; ++i) {
-            T1 diff = array_data[i] - mean;
-            diff = diff*diff*diff;
-            sum += diff;
-        }
-        size_t new_size = size - 1;
-        new_size = new_size * new_size * new_size;
-        sum /= (T1)new_size;
-        return sum;
+        return calc_descriptive_stats<T1>(array_data).skewness;
     };
 
     /** \brief Посчитать стандартную ошибку
@@ -174,10 +467,7 @@ namespace xtechnical_statistics {
      */
     template<class T1, class T2>
     T1 calc_standard_error(const T2 &array_data) {
-        T1 std_dev = calc_std_dev_sample<T1>(array_data);
-        const size_t size = array_data.size();
-        if(size == 0) return (T1)0;
-        return std_dev/std::sqrt((T1)size);
+        return calc_descriptive_stats<T1>(array_data).standard_error;
     };
 
     /** \brief Посчитать ошибку выборки
@@ -199,17 +489,7 @@ namespace xtechnical_statistics {
      */
     template<class T1, class T2>
     T1 calc_coefficient_variance(const T2 &array_data) {
-        size_t size = array_data.size();
-        if(size < 2) return (T1)0;
-        T1 mean = calc_mean_value<T1>(array_data);
-        T1 sum = 0;
-        for(size_t i = 0; i < size; ++i) {
-            T1 diff = array_data[i] - mean;
-            diff*=diff;
-            sum += diff;
-        }
-        sum /= (T1)(size - 1);
-        return std::sqrt(sum)/mean;
+        return calc_descriptive_stats<T1>(array_data).coefficient_variance;
     }
 
     /** \brief Посчитать отношение сигнал / шум
@@ -226,17 +506,7 @@ namespace xtechnical_statistics {
      */
     template<class T1, class T2>
     T1 calc_signal_to_noise_ratio(const T2 &array_data) {
-        const size_t size = array_data.size();
-        if(size < 2) return (T1)0;
-        T1 mean = calc_mean_value<T1>(array_data);
-        T1 sum = 0;
-        for(size_t i = 0; i < size; ++i) {
-            T1 diff = array_data[i] - mean;
-            diff*=diff;
-            sum += diff;
-        }
-        sum /= (T1)(size - 1);
-        return mean/std::sqrt(sum);
+        return calc_descriptive_stats<T1>(array_data).signal_to_noise_ratio;
     }
 
     /** \brief Коэффициент эксцесса
@@ -249,26 +519,183 @@ namespace xtechnical_statistics {
      */
     template<class T1, class T2>
     T1 calc_excess(const T2 &array_data) {
-        const size_t size = array_data.size();
-        if(size == 0) return (T1)0;
-        T1 mean = calc_mean_value<T1>(array_data);
-        T1 u4 = 0;
-        T1 std_dev = 0;
-        for(size_t i = 0; i < size; ++i) {
-            T1 diff = array_data[i] - mean;
-            diff *= diff;
-            std_dev += diff;
-            u4 += diff * diff;
-        }
-        u4 /= (T1)size;
-        std_dev /= (T1)(size - 1);
-        std_dev = std::sqrt(std_dev);
-        std_dev *= std_dev;
-        std_dev = std_dev * std_dev;
-        return u4/std_dev - 3.0;
+        return calc_descriptive_stats<T1>(array_data).excess;
     }
 
 
+    /** \brief Накопитель моментов выборки
+     *
+     * Хранит количество элементов, среднее и суммы степеней отклонений
+     * от среднего (M2, M3, M4), обновляемые по формулам Уэлфорда / Пебая.
+     * Элементы можно добавлять (push), удалять ранее добавленные (pop)
+     * для скользящего окна и объединять накопители (merge), например
+     * посчитанные параллельно по частям данных.
+     * Моменты возвращаются так же, как их считают функции calc_*.
+     */
+    template<class T>
+    class Moments {
+    private:
+        size_t count_ = 0;
+        T mean_ = 0;
+        T m2_ = 0;
+        T m3_ = 0;
+        T m4_ = 0;
+
+    public:
+
+        Moments() {};
+
+        /** \brief Добавить элемент
+         * \param value Значение
+         */
+        void push(const T value) {
+            const T n1 = (T)count_;
+            ++count_;
+            const T n = (T)count_;
+            const T delta = value - mean_;
+            const T delta_n = delta / n;
+            const T delta_n2 = delta_n * delta_n;
+            const T term = delta * delta_n * n1;
+            mean_ += delta_n;
+            m4_ += term * delta_n2 * (n * n - 3 * n + 3) + 6 * delta_n2 * m2_ - 4 * delta_n * m3_;
+            m3_ += term * delta_n * (n - 2) - 3 * delta_n * m2_;
+            m2_ += term;
+        }
+
+        /** \brief Удалить ранее добавленный элемент
+         *
+         * При длительной работе в скользящем окне накапливается ошибка
+         * округления, поэтому накопитель стоит периодически пересчитывать
+         * \param value Значение, которое было добавлено ранее
+         * \return вернет false, если накопитель пуст
+         */
+        bool pop(const T value) {
+            if(count_ == 0) return false;
+            if(count_ == 1) {
+                clear();
+                return true;
+            }
+            const T n = (T)count_;
+            const T nb = n - 1;
+            const T mean_b = (n * mean_ - value) / nb;
+            const T delta = value - mean_b;
+            const T delta2 = delta * delta;
+            const T m2_b = m2_ - delta2 * nb / n;
+            const T m3_b = m3_ - delta2 * delta * nb * (nb - 1) / (n * n) + 3 * delta * m2_b / n;
+            const T m4_b = m4_ - delta2 * delta2 * nb * (nb * nb - nb + 1) / (n * n * n) -
+                6 * delta2 * m2_b / (n * n) + 4 * delta * m3_b / n;
+            --count_;
+            mean_ = mean_b;
+            m2_ = m2_b;
+            m3_ = m3_b;
+            m4_ = m4_b;
+            return true;
+        }
+
+        /** \brief Объединить с другим накопителем
+         * \param other Накопитель
+         */
+        void merge(const Moments<T> &other) {
+            if(other.count_ == 0) return;
+            if(count_ == 0) {
+                *this = other;
+                return;
+            }
+            const T na = (T)count_;
+            const T nb = (T)other.count_;
+            const T n = na + nb;
+            const T delta = other.mean_ - mean_;
+            const T delta2 = delta * delta;
+            const T m2 = m2_ + other.m2_ + delta2 * na * nb / n;
+            const T m3 = m3_ + other.m3_ +
+                delta2 * delta * na * nb * (na - nb) / (n * n) +
+                3 * delta * (na * other.m2_ - nb * m2_) / n;
+            const T m4 = m4_ + other.m4_ +
+                delta2 * delta2 * na * nb * (na * na - na * nb + nb * nb) / (n * n * n) +
+                6 * delta2 * (na * na * other.m2_ + nb * nb * m2_) / (n * n) +
+                4 * delta * (na * other.m3_ - nb * m3_) / n;
+            count_ += other.count_;
+            mean_ += delta * nb / n;
+            m2_ = m2;
+            m3_ = m3;
+            m4_ = m4;
+        }
+
+        /** \brief Получить количество элементов
+         * \return количество элементов
+         */
+        inline size_t get_count() const {
+            return count_;
+        }
+
+        /** \brief Получить среднее значение
+         * \return среднее значение
+         */
+        inline T get_mean() const {
+            return mean_;
+        }
+
+        /** \brief Получить дисперсию выборки
+         * \return дисперсия выборки (n - 1)
+         */
+        inline T get_variance() const {
+            if(count_ < 2) return (T)0;
+            return std::max(m2_, (T)0) / (T)(count_ - 1);
+        }
+
+        /** \brief Получить стандартное отклонение выборки
+         * \return стандартное отклонение, см. calc_std_dev_sample
+         */
+        inline T get_std_dev() const {
+            return std::sqrt(get_variance());
+        }
+
+        /** \brief Получить стандартное отклонение популяции
+         * \return стандартное отклонение, см. calc_std_dev_population
+         */
+        inline T get_std_dev_population() const {
+            if(count_ == 0) return (T)0;
+            return std::sqrt(std::max(m2_, (T)0) / (T)count_);
+        }
+
+        /** \brief Получить асимметрию
+         * \return асимметрия, см. calc_skewness
+         */
+        inline T get_skewness() const {
+            if(count_ < 2) return (T)0;
+            const T n_dec = (T)(count_ - 1);
+            return m3_ / (n_dec * n_dec * n_dec);
+        }
+
+        /** \brief Получить коэффициент эксцесса
+         * \return коэффициент эксцесса, см. calc_excess
+         */
+        inline T get_excess() const {
+            if(count_ < 2) return (T)0;
+            const T variance = get_variance();
+            return (m4_ / (T)count_) / (variance * variance) - 3.0;
+        }
+
+        /** \brief Получить стандартную ошибку
+         * \return стандартная ошибка, см. calc_standard_error
+         */
+        inline T get_standard_error() const {
+            if(count_ < 2) return (T)0;
+            return get_std_dev() / std::sqrt((T)count_);
+        }
+
+        /** \brief Очистить накопитель
+         */
+        void clear() {
+            count_ = 0;
+            mean_ = 0;
+            m2_ = 0;
+            m3_ = 0;
+            m4_ = 0;
+        }
+    };
+
+
     template<class T1, class T2>
     T1 calc_laplace(T2 t) {
         constexpr double pi = 3.14159265358979323846;
@@ -291,21 +718,206 @@ namespace xtechnical_statistics {
         return result;
     }
 
+    /** \brief Посчитать функцию Лапласа через erf
+     *
+     * Аналог calc_integral_laplace без численного интегрирования
+     * \param t Аргумент функции
+     * \return значение интеграла от 0 до t плотности стандартного нормального распределения
+     */
+    template<class T1, class T2>
+    T1 calc_laplace_function(T2 t) {
+        return 0.5 * std::erf((double)t * 0.70710678118654752440);
+    }
+
+    /** \brief Экспонента без вызова libm и без ветвлений
+     *
+     * x = n*ln2 + r, exp(r) считается рядом Тейлора до r^13, 2^n прибавляется
+     * к показателю степени целочисленно. Относительная ошибка порядка 1e-16
+     * \param x Аргумент функции, от -708 до 709
+     * \return exp(x)
+     */
+    inline double calc_exp_branchless(const double x) {
+        const double shift = 6755399441055744.0; // 1.5 * 2^52, округляет до целого
+        const double k = x * 1.4426950408889634074 + shift;
+        const double n = k - shift;
+        const double r = (x - n * 6.93147180369123816490e-01) - n * 1.90821492927058770002e-10;
+        double p = 1.0 / 6227020800.0;
+        p = p * r + 1.0 / 479001600.0;
+        p = p * r + 1.0 / 39916800.0;
+        p = p * r + 1.0 / 3628800.0;
+        p = p * r + 1.0 / 362880.0;
+        p = p * r + 1.0 / 40320.0;
+        p = p * r + 1.0 / 5040.0;
+        p = p * r + 1.0 / 720.0;
+        p = p * r + 1.0 / 120.0;
+        p = p * r + 1.0 / 24.0;
+        p = p * r + 1.0 / 6.0;
+        p = p * r + 0.5;
+        p = p * r + 1.0;
+        p = p * r + 1.0;
+        uint64_t k_bits = 0, p_bits = 0;
+        std::memcpy(&k_bits, &k, sizeof(k));
+        std::memcpy(&p_bits, &p, sizeof(p));
+        p_bits += k_bits << 52;
+        std::memcpy(&p, &p_bits, sizeof(p));
+        return p;
+    }
+
+    /** \brief Квадратный корень без вызова libm и без ветвлений
+     *
+     * Начальное приближение 1/sqrt(x) по битам числа уточняется методом Ньютона.
+     * Относительная ошибка порядка 1e-16
+     * \param x Аргумент функции, положительное конечное число
+     * \return sqrt(x)
+     */
+    inline double calc_sqrt_branchless(const double x) {
+        uint64_t bits = 0;
+        std::memcpy(&bits, &x, sizeof(x));
+        bits = 0x5FE6EB50C7B537A9ULL - (bits >> 1);
+        double y = 0;
+        std::memcpy(&y, &bits, sizeof(y));
+        const double h = 0.5 * x;
+        y = y * (1.5 - h * y * y);
+        y = y * (1.5 - h * y * y);
+        y = y * (1.5 - h * y * y);
+        y = y * (1.5 - h * y * y);
+        const double s = x * y;
+        return s + 0.5 * y * (x - s * s);
+    }
+
     /** \brief Посчитать вероятность, с которой винрейт играемой стратегии выше заданного числа
      *
+     * Используется численное интегрирование (calc_integral_laplace).
+     * Вариант оставлен для сравнения, см. calc_probability_winrate без параметра precision
      * \param threshold_winrate Заданнывй винрейт
      * \param win_bet Количество удачных ставок
      * \param number_bet Количество ставок
+     * \param precision Шаг интегрирования
      * \return Вероятность
      */
     template<class T1, class T2>
-    T1 calc_probability_winrate(const T1 threshold_winrate, const T2 win_bet, const T2 number_bet, double precision = 0.01) {
+    T1 calc_probability_winrate(const T1 threshold_winrate, const T2 win_bet, const T2 number_bet, double precision) {
         if(number_bet <= 0 || number_bet == 1) return 0;
         const double w = (double)win_bet/(double)number_bet;
         if(w == 1) return 1;
         const double t = (w - threshold_winrate) * std::sqrt(((double)number_bet / w) / (1.0 - w));
         return calc_integral_laplace<T1>(t, precision) + 0.5;
     }
+
+    /** \brief Посчитать вероятность, с которой винрейт играемой стратегии выше заданного числа
+     *
+     * Функция нормального распределения считается через erfc
+     * \param threshold_winrate Заданнывй винрейт
+     * \param win_bet Количество удачных ставок
+     * \param number_bet Количество ставок
+     * \return Вероятность
+     */
+    template<class T1, class T2>
+    T1 calc_probability_winrate(const T1 threshold_winrate, const T2 win_bet, const T2 number_bet) {
+        if(number_bet <= 0 || number_bet == 1) return 0;
+        const double w = (double)win_bet/(double)number_bet;
+        if(w >= 1) return 1;
+        if(w <= 0) return 0;
+        const double t = (w - threshold_winrate) * std::sqrt(((double)number_bet / w) / (1.0 - w));
+        return 0.5 * std::erfc(-t * 0.70710678118654752440);
+    }
+
+    /** \brief Посчитать вероятность, с которой винрейт играемой стратегии выше заданного числа, для массива стратегий
+     *
+     * Стратегии обрабатываются блоками по 64. Каждый шаг блока - цикл фиксированной
+     * длины без ветвлений и вызовов libm (условия заменены масками 0/1, exp и sqrt -
+     * calc_exp_branchless и calc_sqrt_branchless), поэтому GCC векторизует его
+     * с -O2 и -O3 без -ffast-math. erfc считается разложением Чебышева
+     * (Numerical Recipes, erfccheb), отличие от скалярной версии порядка 1e-16
+     * \param threshold_winrate Заданнывй винрейт
+     * \param win_bet Массив количества удачных ставок
+     * \param number_bet Массив количества ставок
+     * \param out Массив вероятностей
+     * \param size Размер массивов
+     */
+    template<class T1, class T2>
+    void calc_probability_winrate(
+            const T1 threshold_winrate,
+            const T2 *win_bet,
+            const T2 *number_bet,
+            T1 *out,
+            const size_t size) {
+        /* коэффициенты Чебышева для erfc(z) = t * exp(-z^2 + Σc[j]*T_j(4t - 2) - c[0]/2), t = 2 / (2 + z) */
+        static const double erfc_coeff[28] = {
+            -1.3026537197817094, 6.4196979235649026e-1, 1.9476473204185836e-2,
+            -9.561514786808631e-3, -9.46595344482036e-4, 3.66839497852761e-4,
+            4.2523324806907e-5, -2.0278578112534e-5, -1.624290004647e-6,
+            1.303655835580e-6, 1.5626441722e-8, -8.5238095915e-8,
+            6.529054439e-9, 5.059343495e-9, -9.91364156e-10,
+            -2.27365122e-10, 9.6467911e-11, 2.394038e-12,
+            -6.886027e-12, 8.94487e-13, 3.13092e-13,
+            -1.12708e-13, 3.81e-16, 7.106e-15,
+            -1.523e-15, -9.4e-17, 1.21e-16, -2.8e-17};
+        /* 26.5 - предел |z|, при котором exp еще не уходит в денормализованные числа */
+        const uint64_t z_limit_bits = 0x403A800000000000ULL;
+        const size_t BLOCK_SIZE = 64;
+        const double threshold = (double)threshold_winrate;
+        double n[BLOCK_SIZE], w[BLOCK_SIZE], mask[BLOCK_SIZE], p[BLOCK_SIZE];
+        double t[BLOCK_SIZE], ty[BLOCK_SIZE], d[BLOCK_SIZE], dd[BLOCK_SIZE];
+        for(size_t i = 0; i < size; i += BLOCK_SIZE) {
+            const size_t len = std::min(size - i, BLOCK_SIZE);
+            for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                n[k] = 0;
+                w[k] = 0;
+            }
+            for(size_t k = 0; k < len; ++k) {
+                n[k] = (double)number_bet[i + k];
+                w[k] = (double)win_bet[i + k];
+            }
+            /* число ставок меньше 2: вероятность 0 */
+            for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                mask[k] = ((n[k] > 0) & (n[k] != 1)) ? 1.0 : 0.0;
+            }
+            for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                n[k] = n[k] * mask[k] + 2.0 * (1.0 - mask[k]);
+                w[k] = w[k] / n[k];
+            }
+            /* винрейт 1: вероятность 1, винрейт 0: вероятность 0 */
+            for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                p[k] = ((mask[k] > 0) & (w[k] >= 1)) ? 1.0 : 0.0;
+                mask[k] = ((mask[k] > 0) & (w[k] > 0) & (w[k] < 1)) ? 1.0 : 0.0;
+            }
+            for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                const double wc = w[k] * mask[k] + 0.5 * (1.0 - mask[k]);
+                w[k] = (wc - threshold) * calc_sqrt_branchless((n[k] / wc) / (1.0 - wc));
+            }
+            /* erfc(-w / sqrt(2)) для |z| = |w| / sqrt(2), ограниченного z_limit_bits */
+            for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                const double z = std::abs(w[k] * 0.70710678118654752440);
+                uint64_t z_bits = 0;
+                std::memcpy(&z_bits, &z, sizeof(z));
+                const uint64_t is_big = 0 - ((z_limit_bits - z_bits) >> 63);
+                z_bits = (z_bits & ~is_big) | (z_limit_bits & is_big);
+                std::memcpy(&n[k], &z_bits, sizeof(z_bits));
+                t[k] = 2.0 / (2.0 + n[k]);
+                ty[k] = 4.0 * t[k] - 2.0;
+                d[k] = 0;
+                dd[k] = 0;
+            }
+            for(size_t j = 27; j > 0; --j) {
+                for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                    const double temp = d[k];
+                    d[k] = ty[k] * d[k] - dd[k] + erfc_coeff[j];
+                    dd[k] = temp;
+                }
+            }
+            for(size_t k = 0; k < BLOCK_SIZE; ++k) {
+                const double r = t[k] * calc_exp_branchless(
+                    -n[k] * n[k] + 0.5 * (erfc_coeff[0] + ty[k] * d[k]) - dd[k]);
+                /* erfc(-z) = 2 - erfc(z) */
+                const double is_positive = w[k] > 0 ? 1.0 : 0.0;
+                p[k] += mask[k] * 0.5 * (2.0 * is_positive + (1.0 - 2.0 * is_positive) * r);
+            }
+            for(size_t k = 0; k < len; ++k) {
+                out[i + k] = (T1)p[k];
+            }
+        }
+    }
 };
 
 #endif // XTECHNICAL_STATISTICS_HPP_INCLUDED